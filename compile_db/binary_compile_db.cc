@@ -0,0 +1,257 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/compile_db/binary_compile_db.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <cstring>
+#include <fstream>
+#include <map>
+#include <numeric>
+#include "absl/strings/str_join.h"
+#include "absl/strings/str_split.h"
+
+namespace {
+
+constexpr char kMagic[8] = {'C', 'I', 'C', 'M', 'P', 'D', 'B', '1'};
+constexpr size_t kHeaderWords = 8;
+constexpr size_t kEntryFields = 8;
+
+enum EntryField {
+  kFile,
+  kDirectory,
+  kOutput,
+  kPath,
+  kArgumentsBegin,
+  kArgumentsCount,
+  kDependenciesBegin,
+  kDependenciesCount,
+};
+
+/// Removes ".", ".." and repeated slashes from path without resolving
+/// symlinks, like Go's filepath.Clean.
+std::string clean_path(absl::string_view path) {
+  auto rooted = !path.empty() && path.front() == '/';
+  std::vector<absl::string_view> parts;
+  for (auto part : absl::StrSplit(path, '/', absl::SkipEmpty())) {
+    if (part == ".") continue;
+    if (part == ".." && !parts.empty() && parts.back() != "..") {
+      parts.pop_back();
+    } else if (part != ".." || !rooted) {
+      parts.push_back(part);
+    }
+  }
+  auto cleaned = absl::StrJoin(parts, "/");
+  if (rooted) return "/" + cleaned;
+  return cleaned.empty() ? "." : cleaned;
+}
+
+std::string absolute_path(const std::string &file,
+                          const std::string &directory) {
+  if (file.empty()) return file;
+  if (file.front() == '/' || directory.empty()) return clean_path(file);
+  return clean_path(directory + "/" + file);
+}
+
+/// Reads a little-endian word of the mapped file.
+uint32_t load_word(const uint32_t *word) {
+  auto bytes = reinterpret_cast<const unsigned char *>(word);
+  return uint32_t{bytes[0]} | uint32_t{bytes[1]} << 8 |
+         uint32_t{bytes[2]} << 16 | uint32_t{bytes[3]} << 24;
+}
+
+/// Interns the strings of the records in the order the writer emits them.
+class StringTable {
+ public:
+  uint32_t Intern(const std::string &value) {
+    auto inserted = ids_.emplace(value, static_cast<uint32_t>(values_.size()));
+    if (inserted.second) values_.push_back(&inserted.first->first);
+    return inserted.first->second;
+  }
+
+  const std::vector<const std::string *> &values() const { return values_; }
+
+ private:
+  std::map<std::string, uint32_t> ids_;
+  std::vector<const std::string *> values_;
+};
+
+void append_words(std::string *out, const std::vector<uint32_t> &words) {
+  for (auto word : words) {
+    for (int shift = 0; shift < 32; shift += 8) {
+      out->push_back(static_cast<char>(word >> shift));
+    }
+  }
+}
+
+}  // anonymous namespace
+
+std::unique_ptr<BinaryCompileDb> BinaryCompileDb::Open(
+    const std::string &path) {
+  auto fd = open(path.data(), O_RDONLY | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+
+  struct stat info;
+  if (fstat(fd, &info) != 0 || info.st_size == 0) {
+    close(fd);
+    return nullptr;
+  }
+  auto size = static_cast<size_t>(info.st_size);
+  auto mapping = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return nullptr;
+
+  std::unique_ptr<BinaryCompileDb> db(
+      new BinaryCompileDb(static_cast<const char *>(mapping), size));
+  if (!db->ReadHeader()) return nullptr;
+  return db;
+}
+
+BinaryCompileDb::~BinaryCompileDb() {
+  munmap(const_cast<char *>(data_), size_);
+}
+
+bool BinaryCompileDb::ReadHeader() {
+  if (size_ < kHeaderWords * sizeof(uint32_t)) return false;
+  if (memcmp(data_, kMagic, sizeof(kMagic)) != 0) return false;
+
+  auto header = reinterpret_cast<const uint32_t *>(data_);
+  string_count_ = load_word(&header[2]);
+  entry_count_ = load_word(&header[3]);
+  list_size_ = load_word(&header[4]);
+  string_data_size_ = load_word(&header[5]);
+
+  uint64_t words = kHeaderWords;
+  string_offsets_ = header + words;
+  words += uint64_t{string_count_} + 1;
+  entries_ = header + words;
+  words += uint64_t{entry_count_} * kEntryFields;
+  lists_ = header + words;
+  words += list_size_;
+  path_index_ = header + words;
+  words += entry_count_;
+  string_data_ = reinterpret_cast<const char *>(header + words);
+
+  auto expected_size = words * sizeof(uint32_t) + string_data_size_;
+  if (expected_size > size_) return false;
+  return load_word(&string_offsets_[string_count_]) <= string_data_size_;
+}
+
+absl::string_view BinaryCompileDb::String(uint32_t id) const {
+  if (id >= string_count_) return {};
+  auto begin = load_word(&string_offsets_[id]);
+  auto end = load_word(&string_offsets_[id + 1]);
+  if (begin >= end || end > string_data_size_) return {};
+  return absl::string_view(string_data_ + begin, end - begin - 1);
+}
+
+std::vector<absl::string_view> BinaryCompileDb::List(uint32_t begin,
+                                                     uint32_t count) const {
+  std::vector<absl::string_view> result;
+  if (uint64_t{begin} + count > list_size_) return result;
+
+  result.reserve(count);
+  for (uint32_t i = begin; i < begin + count; i++) {
+    result.emplace_back(String(load_word(&lists_[i])));
+  }
+  return result;
+}
+
+uint32_t BinaryCompileDb::EntryField(uint32_t index, int field) const {
+  return load_word(entries_ + uint64_t{index} * kEntryFields + field);
+}
+
+BinaryCompileDbEntry BinaryCompileDb::Entry(size_t index) const {
+  if (index >= entry_count_) return {};
+
+  BinaryCompileDbEntry entry;
+  entry.file = String(EntryField(index, kFile));
+  entry.directory = String(EntryField(index, kDirectory));
+  entry.output = String(EntryField(index, kOutput));
+  entry.path = String(EntryField(index, kPath));
+  entry.arguments = List(EntryField(index, kArgumentsBegin),
+                         EntryField(index, kArgumentsCount));
+  entry.dependencies = List(EntryField(index, kDependenciesBegin),
+                            EntryField(index, kDependenciesCount));
+  return entry;
+}
+
+std::vector<BinaryCompileDbEntry> BinaryCompileDb::Lookup(
+    absl::string_view path) const {
+  auto path_of = [this](uint32_t index) {
+    return index < entry_count_ ? String(EntryField(index, kPath))
+                                : absl::string_view();
+  };
+  auto end = path_index_ + entry_count_;
+  auto first = std::lower_bound(
+      path_index_, end, path,
+      [&](const uint32_t &index, absl::string_view p) {
+        return path_of(load_word(&index)) < p;
+      });
+  auto last = std::upper_bound(
+      first, end, path, [&](absl::string_view p, const uint32_t &index) {
+        return p < path_of(load_word(&index));
+      });
+
+  std::vector<BinaryCompileDbEntry> entries;
+  for (auto it = first; it != last; ++it) {
+    entries.emplace_back(Entry(load_word(it)));
+  }
+  return entries;
+}
+
+bool WriteBinaryCompileDb(const std::string &path,
+                          const std::vector<CompileDbRecord> &records) {
+  StringTable strings;
+  std::vector<uint32_t> entries;
+  std::vector<uint32_t> lists;
+  std::vector<std::string> paths;
+
+  auto add_list = [&](const std::vector<std::string> &values) {
+    entries.push_back(lists.size());
+    entries.push_back(values.size());
+    for (const auto &value : values) lists.push_back(strings.Intern(value));
+  };
+
+  for (const auto &record : records) {
+    paths.emplace_back(absolute_path(record.file, record.directory));
+    entries.push_back(strings.Intern(record.file));
+    entries.push_back(strings.Intern(record.directory));
+    entries.push_back(strings.Intern(record.output));
+    entries.push_back(strings.Intern(paths.back()));
+    add_list(record.arguments);
+    add_list(record.dependencies);
+  }
+
+  std::vector<uint32_t> path_index(records.size());
+  std::iota(path_index.begin(), path_index.end(), 0);
+  std::stable_sort(
+      path_index.begin(), path_index.end(),
+      [&](uint32_t lhs, uint32_t rhs) { return paths[lhs] < paths[rhs]; });
+
+  std::vector<uint32_t> string_offsets{0};
+  std::string string_data;
+  for (const auto *value : strings.values()) {
+    string_data.append(value->data(), value->size() + 1);
+    string_offsets.push_back(string_data.size());
+  }
+  string_data.resize((string_data.size() + 3) / 4 * 4, '\0');
+
+  std::string out(kMagic, sizeof(kMagic));
+  append_words(&out, {static_cast<uint32_t>(strings.values().size()),
+                      static_cast<uint32_t>(records.size()),
+                      static_cast<uint32_t>(lists.size()),
+                      static_cast<uint32_t>(string_data.size()), 0, 0});
+  append_words(&out, string_offsets);
+  append_words(&out, entries);
+  append_words(&out, lists);
+  append_words(&out, path_index);
+  out += string_data;
+
+  std::ofstream file(path, std::ios::binary | std::ios::trunc);
+  file.write(out.data(), out.size());
+  return static_cast<bool>(file);
+}
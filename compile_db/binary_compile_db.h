@@ -0,0 +1,93 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+#include "absl/strings/string_view.h"
+
+/// The binary compilation database stores every string once and has an index
+/// sorted by absolute file path, so a single file can be looked up in a mapped
+/// file without parsing it. All integers are little-endian uint32.
+///
+///   header          magic "CICMPDB1", string count, entry count, list size,
+///                   string data size, two reserved words
+///   string offsets  string count + 1 offsets into the string data
+///   entries         file, directory, output, path, arguments begin and
+///                   count, dependencies begin and count per entry
+///   lists           string ids of the arguments and dependencies
+///   path index      entry ids sorted by their path
+///   string data     the '\0' terminated strings, padded to 4 bytes
+///
+/// The path of an entry is its file made absolute with its directory and
+/// cleaned lexically like Go's filepath.Clean, i.e. without "." and ".."
+/// components. The format is written by the Go package compile_db/compiledb
+/// as well.
+struct BinaryCompileDbEntry {
+  absl::string_view file;
+  absl::string_view directory;
+  absl::string_view output;
+  absl::string_view path;
+  std::vector<absl::string_view> arguments;
+  std::vector<absl::string_view> dependencies;
+};
+
+/// A compile command to write into a binary compilation database.
+struct CompileDbRecord {
+  std::string file;
+  std::string directory;
+  std::string output;
+  std::vector<std::string> arguments;
+  std::vector<std::string> dependencies;
+};
+
+/// A read-only, memory mapped binary compilation database. The string views
+/// of its entries stay valid as long as the database is alive.
+class BinaryCompileDb {
+ public:
+  /// Maps the database at path.
+  /// @returns nothing if the file cannot be mapped or is malformed
+  static std::unique_ptr<BinaryCompileDb> Open(const std::string &path);
+
+  BinaryCompileDb(const BinaryCompileDb &) = delete;
+  BinaryCompileDb &operator=(const BinaryCompileDb &) = delete;
+  ~BinaryCompileDb();
+
+  size_t size() const { return entry_count_; }
+
+  BinaryCompileDbEntry Entry(size_t index) const;
+
+  /// @returns the entries whose absolute file path is path, which has to be
+  /// cleaned like the paths of the entries
+  std::vector<BinaryCompileDbEntry> Lookup(absl::string_view path) const;
+
+ private:
+  BinaryCompileDb(const char *data, size_t size) : data_(data), size_(size) {}
+
+  bool ReadHeader();
+
+  absl::string_view String(uint32_t id) const;
+
+  std::vector<absl::string_view> List(uint32_t begin, uint32_t count) const;
+
+  uint32_t EntryField(uint32_t index, int field) const;
+
+  const char *data_;
+  size_t size_;
+  uint32_t string_count_ = 0;
+  uint32_t entry_count_ = 0;
+  uint32_t list_size_ = 0;
+  uint32_t string_data_size_ = 0;
+  const uint32_t *string_offsets_ = nullptr;
+  const uint32_t *entries_ = nullptr;
+  const uint32_t *lists_ = nullptr;
+  const uint32_t *path_index_ = nullptr;
+  const char *string_data_ = nullptr;
+};
+
+/// Writes records as a binary compilation database to path.
+/// @returns whether the database could be written
+bool WriteBinaryCompileDb(const std::string &path,
+                          const std::vector<CompileDbRecord> &records);
@@ -0,0 +1,195 @@
+// Package compiledb reads and writes the binary compilation database format
+// described in compile_db/binary_compile_db.h.
+package compiledb
+
+import (
+	"bytes"
+	"encoding/binary"
+	"errors"
+	"io"
+	"io/ioutil"
+	"path/filepath"
+	"sort"
+	"strings"
+
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+// Magic starts every binary compilation database.
+const Magic = "CICMPDB1"
+
+const (
+	headerWords = 8
+	entryFields = 8
+)
+
+// ErrFormat is returned for data that is not a binary compilation database.
+var ErrFormat = errors.New("not a binary compilation database")
+
+// Write writes cmds to w in the binary format.
+func Write(w io.Writer, cmds []types.CompilationCommand) error {
+	var (
+		strs    stringTable
+		entries = make([]uint32, 0, entryFields*len(cmds))
+		lists   []uint32
+		paths   = make([]string, len(cmds))
+	)
+	addList := func(values []string) {
+		entries = append(entries, uint32(len(lists)), uint32(len(values)))
+		for _, v := range values {
+			lists = append(lists, strs.Intern(v))
+		}
+	}
+	for i, cmd := range cmds {
+		paths[i] = absolutePath(cmd.File, cmd.Directory)
+		entries = append(entries,
+			strs.Intern(cmd.File),
+			strs.Intern(cmd.Directory),
+			strs.Intern(cmd.Output),
+			strs.Intern(paths[i]))
+		addList(cmd.Arguments)
+		addList(cmd.Dependencies)
+	}
+
+	pathIndex := make([]uint32, len(cmds))
+	for i := range pathIndex {
+		pathIndex[i] = uint32(i)
+	}
+	sort.SliceStable(pathIndex, func(i, j int) bool {
+		return paths[pathIndex[i]] < paths[pathIndex[j]]
+	})
+
+	var data bytes.Buffer
+	offsets := []uint32{0}
+	for _, s := range strs.Values() {
+		data.WriteString(s)
+		data.WriteByte(0)
+		offsets = append(offsets, uint32(data.Len()))
+	}
+	for data.Len()%4 != 0 {
+		data.WriteByte(0)
+	}
+
+	header := []uint32{uint32(len(strs.Values())), uint32(len(cmds)),
+		uint32(len(lists)), uint32(data.Len()), 0, 0}
+	if _, err := io.WriteString(w, Magic); err != nil {
+		return err
+	}
+	for _, words := range [][]uint32{header, offsets, entries, lists, pathIndex} {
+		if err := binary.Write(w, binary.LittleEndian, words); err != nil {
+			return err
+		}
+	}
+	_, err := w.Write(data.Bytes())
+	return err
+}
+
+// Read decodes all entries of a binary compilation database.
+func Read(data []byte) ([]types.CompilationCommand, error) {
+	if len(data) < 4*headerWords || string(data[:len(Magic)]) != Magic {
+		return nil, ErrFormat
+	}
+	word := func(i uint64) uint32 {
+		return binary.LittleEndian.Uint32(data[4*i:])
+	}
+	stringCount := uint64(word(2))
+	entryCount := uint64(word(3))
+	listSize := uint64(word(4))
+	dataSize := uint64(word(5))
+
+	offsets := uint64(headerWords)
+	entries := offsets + stringCount + 1
+	lists := entries + entryCount*entryFields
+	stringData := 4 * (lists + listSize + entryCount)
+	if stringData+dataSize > uint64(len(data)) {
+		return nil, ErrFormat
+	}
+
+	str := func(id uint32) (string, error) {
+		if uint64(id) >= stringCount {
+			return "", ErrFormat
+		}
+		begin, end := uint64(word(offsets+uint64(id))), uint64(word(offsets+uint64(id)+1))
+		if begin >= end || end > dataSize {
+			return "", ErrFormat
+		}
+		return string(data[stringData+begin : stringData+end-1]), nil
+	}
+	list := func(begin, count uint32) ([]string, error) {
+		if uint64(begin)+uint64(count) > listSize {
+			return nil, ErrFormat
+		}
+		var values []string
+		for i := uint64(begin); i < uint64(begin)+uint64(count); i++ {
+			v, err := str(word(lists + i))
+			if err != nil {
+				return nil, err
+			}
+			values = append(values, v)
+		}
+		return values, nil
+	}
+
+	cmds := make([]types.CompilationCommand, entryCount)
+	for i := range cmds {
+		fields := make([]uint32, entryFields)
+		for f := range fields {
+			fields[f] = word(entries + uint64(i)*entryFields + uint64(f))
+		}
+		var err [5]error
+		cmds[i].File, err[0] = str(fields[0])
+		cmds[i].Directory, err[1] = str(fields[1])
+		cmds[i].Output, err[2] = str(fields[2])
+		cmds[i].Arguments, err[3] = list(fields[4], fields[5])
+		cmds[i].Dependencies, err[4] = list(fields[6], fields[7])
+		for _, e := range err {
+			if e != nil {
+				return nil, e
+			}
+		}
+	}
+	return cmds, nil
+}
+
+// ReadFile decodes the binary compilation database at path.
+func ReadFile(path string) ([]types.CompilationCommand, error) {
+	data, err := ioutil.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	return Read(data)
+}
+
+// absolutePath joins directory and a relative file and cleans the result,
+// like the C++ writer does.
+func absolutePath(file, directory string) string {
+	if file == "" {
+		return file
+	}
+	if strings.HasPrefix(file, "/") || directory == "" {
+		return filepath.Clean(file)
+	}
+	return filepath.Clean(directory + "/" + file)
+}
+
+type stringTable struct {
+	ids    map[string]uint32
+	values []string
+}
+
+func (t *stringTable) Intern(value string) uint32 {
+	if id, found := t.ids[value]; found {
+		return id
+	}
+	if t.ids == nil {
+		t.ids = make(map[string]uint32)
+	}
+	id := uint32(len(t.values))
+	t.ids[value] = id
+	t.values = append(t.values, value)
+	return id
+}
+
+func (t *stringTable) Values() []string {
+	return t.values
+}
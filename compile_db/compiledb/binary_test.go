@@ -0,0 +1,63 @@
+package compiledb
+
+import (
+	"bytes"
+	"reflect"
+	"testing"
+
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+var testCommands = []types.CompilationCommand{{
+	Arguments:    []string{"clang", "-c", "hello.c", "-o", "hello.o"},
+	Directory:    "/src",
+	Output:       "hello.o",
+	File:         "hello.c",
+	Dependencies: []string{"/src/hello.c", "/src/hello.h"},
+}, {
+	Arguments: []string{"clang", "-c", "/src/lib/a.c"},
+	Directory: "/src/lib",
+	File:      "/src/lib/a.c",
+}}
+
+func TestRoundTrip(t *testing.T) {
+	var buf bytes.Buffer
+	if err := Write(&buf, testCommands); err != nil {
+		t.Fatal(err)
+	}
+	cmds, err := Read(buf.Bytes())
+	if err != nil {
+		t.Fatal(err)
+	}
+	if !reflect.DeepEqual(cmds, testCommands) {
+		t.Errorf("\ngot  %+v,\nwant %+v", cmds, testCommands)
+	}
+}
+
+func TestReadRejectsTruncatedData(t *testing.T) {
+	var buf bytes.Buffer
+	if err := Write(&buf, testCommands); err != nil {
+		t.Fatal(err)
+	}
+	if _, err := Read(buf.Bytes()[:buf.Len()-8]); err != ErrFormat {
+		t.Errorf("got %v, want ErrFormat", err)
+	}
+	if _, err := Read([]byte("[]")); err != ErrFormat {
+		t.Errorf("got %v, want ErrFormat", err)
+	}
+}
+
+func TestWriteCleansPaths(t *testing.T) {
+	var buf bytes.Buffer
+	cmds := []types.CompilationCommand{{
+		Arguments: []string{"clang", "-c", "../lib/./a.c"},
+		Directory: "/src/build",
+		File:      "../lib/./a.c",
+	}}
+	if err := Write(&buf, cmds); err != nil {
+		t.Fatal(err)
+	}
+	if !bytes.Contains(buf.Bytes(), []byte("\x00/src/lib/a.c\x00")) {
+		t.Error("path of ../lib/./a.c in /src/build is not /src/lib/a.c")
+	}
+}
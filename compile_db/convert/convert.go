@@ -0,0 +1,77 @@
+// Command convert converts a compilation database between the JSON and the
+// binary format. The direction is chosen by the format of the input.
+package main
+
+import (
+	"bufio"
+	"bytes"
+	"encoding/json"
+	"fmt"
+	"io/ioutil"
+	"log"
+	"os"
+
+	"gitlab.com/code-intelligence/core/build_system/compile_db/compiledb"
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+func usage() {
+	fmt.Printf("Usage: %s INPUT OUTPUT\n", os.Args[0])
+	fmt.Println("Converts compile_commands.json to the binary format and back.")
+}
+
+func main() {
+	if len(os.Args) != 3 {
+		usage()
+		os.Exit(1)
+	}
+	input, output := os.Args[1], os.Args[2]
+
+	data, err := ioutil.ReadFile(input)
+	if err != nil {
+		log.Fatal(err)
+	}
+
+	if bytes.HasPrefix(data, []byte(compiledb.Magic)) {
+		err = toJSON(data, output)
+	} else {
+		err = toBinary(data, output)
+	}
+	if err != nil {
+		log.Fatalf("Failed to convert %q: %v", input, err)
+	}
+}
+
+func toJSON(data []byte, output string) error {
+	cmds, err := compiledb.Read(data)
+	if err != nil {
+		return err
+	}
+	out, err := json.MarshalIndent(cmds, "", "    ")
+	if err != nil {
+		return err
+	}
+	return ioutil.WriteFile(output, out, 0644)
+}
+
+func toBinary(data []byte, output string) error {
+	cmds, err := types.ParseCompilationDb(data)
+	if err != nil {
+		return err
+	}
+
+	f, err := os.Create(output)
+	if err != nil {
+		return err
+	}
+	w := bufio.NewWriter(f)
+	if err := compiledb.Write(w, cmds); err != nil {
+		f.Close()
+		return err
+	}
+	if err := w.Flush(); err != nil {
+		f.Close()
+		return err
+	}
+	return f.Close()
+}
@@ -0,0 +1,73 @@
+#include "build_system/compile_db/binary_compile_db.h"
+#include "gtest/gtest.h"
+
+#include <cstdio>
+
+namespace {
+
+const char *DB_PATH = "compile_commands.bin";
+
+std::vector<CompileDbRecord> Records() {
+  return {
+      {"hello.c", "/src", "hello.o", {"clang", "-c", "hello.c", "-o", "hello.o"},
+       {"/src/hello.c", "/src/hello.h"}},
+      {"/src/lib/a.c", "/src/lib", "a.o", {"clang", "-c", "/src/lib/a.c"}, {}},
+      {"lib/b.c", "/src/", "", {"clang", "-c", "lib/b.c"}, {}},
+      {"../lib/./c.c", "/src/build", "", {"clang", "-c", "../lib/./c.c"}, {}},
+  };
+}
+
+}  // namespace
+
+TEST(BinaryCompileDb, LooksUpEntriesByAbsolutePath) {
+  ASSERT_TRUE(WriteBinaryCompileDb(DB_PATH, Records()));
+  auto db = BinaryCompileDb::Open(DB_PATH);
+  ASSERT_TRUE(db);
+  EXPECT_EQ(db->size(), 4u);
+
+  auto entries = db->Lookup("/src/hello.c");
+  ASSERT_EQ(entries.size(), 1u);
+  EXPECT_EQ(entries[0].file, "hello.c");
+  EXPECT_EQ(entries[0].directory, "/src");
+  EXPECT_EQ(entries[0].output, "hello.o");
+  EXPECT_EQ(entries[0].arguments,
+            std::vector<absl::string_view>(
+                {"clang", "-c", "hello.c", "-o", "hello.o"}));
+  EXPECT_EQ(entries[0].dependencies,
+            std::vector<absl::string_view>({"/src/hello.c", "/src/hello.h"}));
+
+  EXPECT_EQ(db->Lookup("/src/lib/a.c").size(), 1u);
+  EXPECT_EQ(db->Lookup("/src/lib/b.c").size(), 1u);
+  auto vpath = db->Lookup("/src/lib/c.c");
+  ASSERT_EQ(vpath.size(), 1u);
+  EXPECT_EQ(vpath[0].file, "../lib/./c.c");
+  EXPECT_EQ(vpath[0].path, "/src/lib/c.c");
+  EXPECT_TRUE(db->Lookup("/src/missing.c").empty());
+
+  remove(DB_PATH);
+}
+
+TEST(BinaryCompileDb, WritesLittleEndianWords) {
+  ASSERT_TRUE(WriteBinaryCompileDb(DB_PATH, Records()));
+  FILE *file = fopen(DB_PATH, "rb");
+  unsigned char header[16];
+  ASSERT_EQ(fread(header, 1, sizeof(header), file), sizeof(header));
+  fclose(file);
+
+  // the entry count follows the magic and the string count
+  EXPECT_EQ(header[12], 4);
+  EXPECT_EQ(header[13] | header[14] | header[15], 0);
+
+  remove(DB_PATH);
+}
+
+TEST(BinaryCompileDb, RejectsOtherFiles) {
+  FILE *file = fopen(DB_PATH, "w");
+  fputs("[{\"file\": \"hello.c\"}]", file);
+  fclose(file);
+
+  EXPECT_FALSE(BinaryCompileDb::Open(DB_PATH));
+  EXPECT_FALSE(BinaryCompileDb::Open("does/not/exist"));
+
+  remove(DB_PATH);
+}
@@ -0,0 +1,202 @@
+package main
+
+import (
+	"crypto/sha1"
+	"encoding/hex"
+	"fmt"
+	"io/ioutil"
+	"os/exec"
+	"path"
+	"path/filepath"
+	"strings"
+	"sync"
+
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+// batch is a group of compilations that are compiled together as one unity
+// source. A batch of one compilation is compiled on its own.
+type batch struct {
+	directory string
+	arguments []string
+	language  string
+	commands  []types.CompilationCommand
+}
+
+// groupCommands batches the single-source C and C++ compilations of cmds
+// that share their directory, their arguments apart from inputs and outputs
+// and their language into batches of at most maxSources
+// commands. Every other source that is compiled gets a batch of its own,
+// commands that do not compile are dropped.
+func groupCommands(cmds []types.CompilationCommand, maxSources int) (batches []*batch) {
+	open := make(map[string]*batch)
+	seen := make(map[string]struct{})
+	for _, cmd := range cmds {
+		sources, compiles := types.CompiledSources(cmd.Arguments)
+		if !compiles || !types.IsInputFile(cmd.File) {
+			continue
+		}
+		key := strings.Join(append([]string{cmd.Directory, cmd.File}, cmd.Arguments...), "\x00")
+		if _, found := seen[key]; found {
+			continue
+		}
+		seen[key] = struct{}{}
+
+		args := types.SharedArguments(cmd.Arguments)
+		language := types.SourceLanguage(cmd.File)
+		if len(sources) != 1 || language == "" {
+			batches = append(batches, &batch{directory: cmd.Directory, arguments: args,
+				commands: []types.CompilationCommand{cmd}})
+			continue
+		}
+
+		key = strings.Join(append([]string{cmd.Directory, language}, args...), "\x00")
+		b, found := open[key]
+		if !found || len(b.commands) >= maxSources {
+			b = &batch{directory: cmd.Directory, arguments: args, language: language}
+			open[key] = b
+			batches = append(batches, b)
+		}
+		b.commands = append(b.commands, cmd)
+	}
+	return batches
+}
+
+// builder compiles batches. Unity sources, objects and dependency files are
+// all written into dir, the build tree the compilations were recorded in is
+// left untouched.
+type builder struct {
+	dir  string
+	jobs int
+	// logf reports compilations that failed
+	logf func(format string, args ...interface{})
+}
+
+// build compiles all batches with b.jobs compilations in parallel and returns
+// the compilations that produced the objects, in the order of batches. A
+// unity batch that fails to compile is compiled again source by source.
+func (b *builder) build(batches []*batch) ([]types.CompilationCommand, error) {
+	results := make([][]types.CompilationCommand, len(batches))
+	errs := make([]error, len(batches))
+	indices := make(chan int)
+	var wg sync.WaitGroup
+	for w := 0; w < b.jobs; w++ {
+		wg.Add(1)
+		go func() {
+			defer wg.Done()
+			for i := range indices {
+				results[i], errs[i] = b.buildBatch(batches[i])
+			}
+		}()
+	}
+	for i := range batches {
+		indices <- i
+	}
+	close(indices)
+	wg.Wait()
+
+	var (
+		res    []types.CompilationCommand
+		failed []string
+	)
+	for i := range batches {
+		res = append(res, results[i]...)
+		if errs[i] != nil {
+			failed = append(failed, errs[i].Error())
+		}
+	}
+	if len(failed) > 0 {
+		return res, fmt.Errorf("%d compilations failed:\n%s", len(failed), strings.Join(failed, "\n"))
+	}
+	return res, nil
+}
+
+func (b *builder) buildBatch(bt *batch) ([]types.CompilationCommand, error) {
+	if len(bt.commands) > 1 {
+		unity, err := b.buildUnity(bt)
+		if err == nil {
+			return []types.CompilationCommand{unity}, nil
+		}
+		b.logf("Compiling %d sources of %s separately: %v", len(bt.commands), unity.File, err)
+	}
+
+	var (
+		res    []types.CompilationCommand
+		failed []string
+	)
+	for _, cmd := range bt.commands {
+		compiled, err := b.buildSource(bt, cmd)
+		if err != nil {
+			failed = append(failed, fmt.Sprintf("%s: %v", cmd.File, err))
+			continue
+		}
+		res = append(res, compiled)
+	}
+	if len(failed) > 0 {
+		return res, fmt.Errorf("%s", strings.Join(failed, "\n"))
+	}
+	return res, nil
+}
+
+// buildSource compiles the source of cmd on its own, into an object in b.dir.
+// Dependency files written with -MD end up next to the object.
+func (b *builder) buildSource(bt *batch, cmd types.CompilationCommand) (types.CompilationCommand, error) {
+	stem := strings.TrimSuffix(filepath.Base(cmd.File), path.Ext(cmd.File))
+	name := filepath.Join(b.dir, stem+"_"+hash(cmd.Directory, cmd.File))
+	compiled := types.CompilationCommand{
+		Arguments: append(append([]string{}, bt.arguments...), cmd.File, "-o", name+".o"),
+		Directory: cmd.Directory,
+		Output:    name + ".o",
+		File:      cmd.File,
+	}
+	return compiled, run(compiled)
+}
+
+// buildUnity writes a source including all sources of bt and compiles it.
+// The name of the source depends on the batch only, so that an unchanged
+// build produces the same files.
+func (b *builder) buildUnity(bt *batch) (types.CompilationCommand, error) {
+	var content strings.Builder
+	content.WriteString("// Generated by unity, do not edit.\n")
+	for _, cmd := range bt.commands {
+		source := cmd.File
+		if !filepath.IsAbs(source) {
+			source = filepath.Join(cmd.Directory, source)
+		}
+		content.WriteString("#include \"" + source + "\"\n")
+	}
+	name := filepath.Join(b.dir, "unity_"+hash(bt.directory, content.String()))
+	suffix := ".c"
+	if bt.language == "c++" {
+		suffix = ".cc"
+	}
+
+	cmd := types.CompilationCommand{
+		Arguments: append(append([]string{}, bt.arguments...), name+suffix, "-o", name+".o"),
+		Directory: bt.directory,
+		Output:    name + ".o",
+		File:      name + suffix,
+	}
+	if err := ioutil.WriteFile(cmd.File, []byte(content.String()), 0644); err != nil {
+		return cmd, err
+	}
+	return cmd, run(cmd)
+}
+
+func hash(values ...string) string {
+	h := sha1.New()
+	for _, v := range values {
+		h.Write([]byte(v))
+		h.Write([]byte{0})
+	}
+	return hex.EncodeToString(h.Sum(nil)[:8])
+}
+
+func run(cmd types.CompilationCommand) error {
+	c := exec.Command(cmd.Arguments[0], cmd.Arguments[1:]...)
+	c.Dir = cmd.Directory
+	if out, err := c.CombinedOutput(); err != nil {
+		return fmt.Errorf("%v\n%s", err, out)
+	}
+	return nil
+}
@@ -0,0 +1,118 @@
+package main
+
+import (
+	"io/ioutil"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"reflect"
+	"testing"
+
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+func compilation(dir, source string, args ...string) types.CompilationCommand {
+	args = append(append([]string{"cc"}, args...), "-c", source, "-o", source+".o")
+	return types.CompilationCommand{Arguments: args, Directory: dir, Output: source + ".o", File: source}
+}
+
+func TestGroupCommands(t *testing.T) {
+	multi := types.CompilationCommand{Arguments: []string{"cc", "-c", "x.c", "y.c"}, Directory: "/src", File: "x.c"}
+	multiY := multi
+	multiY.File = "y.c"
+	cmds := []types.CompilationCommand{
+		compilation("/src", "a.c", "-O2"),
+		compilation("/src", "b.c", "-O2"),
+		compilation("/src", "c.c", "-O2"),
+		compilation("/src", "d.c", "-O0"),
+		compilation("/other", "e.c", "-O2"),
+		compilation("/src", "f.cc", "-O2"),
+		compilation("/src", "g.s", "-O2"),
+		{Arguments: []string{"cc", "a.o", "b.o", "-o", "prog"}, Directory: "/src"},
+		multi,
+		multiY,
+	}
+
+	var got [][]string
+	for _, b := range groupCommands(cmds, 2) {
+		var files []string
+		for _, cmd := range b.commands {
+			files = append(files, cmd.File)
+		}
+		got = append(got, files)
+	}
+	want := [][]string{{"a.c", "b.c"}, {"c.c"}, {"d.c"}, {"e.c"}, {"f.cc"}, {"g.s"}, {"x.c"}, {"y.c"}}
+	if !reflect.DeepEqual(got, want) {
+		t.Errorf("groupCommands() = %q, want %q", got, want)
+	}
+}
+
+func TestBuildFallsBackOnClash(t *testing.T) {
+	if _, err := exec.LookPath("cc"); err != nil {
+		t.Skip("no C compiler")
+	}
+	dir, err := ioutil.TempDir("", "unity")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	sources := map[string]string{
+		"a.c": "int a(void) { return 1; }\n",
+		"b.c": "int b(void) { return 2; }\n",
+		// the static functions clash when included into one source
+		"c.c": "static int helper(void) { return 3; }\nint c(void) { return helper(); }\n",
+		"d.c": "static int helper(void) { return 4; }\nint d(void) { return helper(); }\n",
+	}
+	for name, content := range sources {
+		if err := ioutil.WriteFile(filepath.Join(dir, name), []byte(content), 0644); err != nil {
+			t.Fatal(err)
+		}
+	}
+	cmds := []types.CompilationCommand{
+		compilation(dir, "a.c", "-MD"), compilation(dir, "b.c", "-MD"),
+		compilation(dir, "c.c", "-MD"), compilation(dir, "d.c", "-MD"),
+		compilation(dir, "e.c", "-MD", "-MF", "e.d"),
+	}
+	if err := ioutil.WriteFile(filepath.Join(dir, "e.c"), []byte("int e;\n"), 0644); err != nil {
+		t.Fatal(err)
+	}
+	out := filepath.Join(dir, "out")
+	if err := os.Mkdir(out, 0755); err != nil {
+		t.Fatal(err)
+	}
+
+	var fallbacks int
+	b := &builder{dir: out, jobs: 2, logf: func(string, ...interface{}) { fallbacks++ }}
+	compiled, err := b.build(groupCommands(cmds, 2))
+	if err != nil {
+		t.Fatal(err)
+	}
+	if fallbacks != 1 {
+		t.Errorf("got %d fallbacks, want 1", fallbacks)
+	}
+
+	var files []string
+	for _, cmd := range compiled {
+		files = append(files, filepath.Base(cmd.File))
+		if filepath.Dir(cmd.Output) != out {
+			t.Errorf("object of %s is %s, want it in %s", cmd.File, cmd.Output, out)
+		}
+		if _, err := os.Stat(cmd.Output); err != nil {
+			t.Errorf("missing object of %s: %v", cmd.File, err)
+		}
+	}
+	if len(files) != 4 || files[1] != "c.c" || files[2] != "d.c" || files[3] != "e.c" {
+		t.Errorf("compiled %q, want a unity source, c.c, d.c and e.c", files)
+	}
+
+	// the recorded build tree is left untouched
+	entries, err := ioutil.ReadDir(dir)
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, entry := range entries {
+		if ext := filepath.Ext(entry.Name()); ext == ".o" || ext == ".d" {
+			t.Errorf("wrote %s into the build tree", entry.Name())
+		}
+	}
+}
@@ -0,0 +1,81 @@
+// Command unity replays the compilations of a compilation database, compiling
+// small sources that share their arguments together as unity sources. It
+// writes the unity sources, all objects and dependency files and a
+// compilation database of the compilations that produced the objects into
+// the output directory; the recorded build tree is not written to.
+package main
+
+import (
+	"bytes"
+	"encoding/json"
+	"flag"
+	"fmt"
+	"io/ioutil"
+	"log"
+	"os"
+	"path/filepath"
+	"runtime"
+
+	"gitlab.com/code-intelligence/core/build_system/compile_db/compiledb"
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+var (
+	maxSources = flag.Int("max_sources", 16, "The maximum number of sources compiled as one unity source")
+	jobs       = flag.Int("jobs", runtime.NumCPU(), "The number of compilations to run in parallel")
+	outDir     = flag.String("out", ".intercept_unity", "The directory for unity sources, objects and the compilation database")
+)
+
+func usage() {
+	fmt.Printf("Usage: %s [OPTIONS] COMPILE_DB\n", os.Args[0])
+	fmt.Println("Replays a JSON or binary compilation database with unity sources.")
+	flag.PrintDefaults()
+}
+
+func main() {
+	flag.Usage = usage
+	flag.Parse()
+	if flag.NArg() != 1 || *maxSources < 1 || *jobs < 1 {
+		usage()
+		os.Exit(1)
+	}
+
+	cmds, err := readCompilationDb(flag.Arg(0))
+	if err != nil {
+		log.Fatalf("Failed to read %q: %v", flag.Arg(0), err)
+	}
+	dir, err := filepath.Abs(*outDir)
+	if err != nil {
+		log.Fatal(err)
+	}
+	if err := os.MkdirAll(dir, 0755); err != nil {
+		log.Fatal(err)
+	}
+
+	batches := groupCommands(cmds, *maxSources)
+	log.Printf("Compiling %d compilations in %d batches", len(cmds), len(batches))
+	b := &builder{dir: dir, jobs: *jobs, logf: log.Printf}
+	compiled, buildErr := b.build(batches)
+
+	out, err := json.MarshalIndent(compiled, "", "    ")
+	if err != nil {
+		log.Fatal(err)
+	}
+	if err := ioutil.WriteFile(filepath.Join(dir, "compile_commands.json"), out, 0644); err != nil {
+		log.Fatal(err)
+	}
+	if buildErr != nil {
+		log.Fatal(buildErr)
+	}
+}
+
+func readCompilationDb(path string) ([]types.CompilationCommand, error) {
+	data, err := ioutil.ReadFile(path)
+	if err != nil {
+		return nil, err
+	}
+	if bytes.HasPrefix(data, []byte(compiledb.Magic)) {
+		return compiledb.Read(data)
+	}
+	return types.ParseCompilationDb(data)
+}
@@ -0,0 +1,79 @@
+package main
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"errors"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"regexp"
+)
+
+var (
+	errDigestMismatch = errors.New("content does not match its digest")
+	errInvalidDigest  = errors.New("invalid digest")
+
+	sha256Hex = regexp.MustCompile(`^[0-9a-f]{64}$`)
+)
+
+// blobStore stores blobs in a directory, named by the SHA-256 of their
+// content. A blob is stored once however often it is uploaded.
+type blobStore struct {
+	dir string
+}
+
+func newBlobStore(dir string) (*blobStore, error) {
+	if err := os.MkdirAll(dir, 0755); err != nil {
+		return nil, err
+	}
+	return &blobStore{dir: dir}, nil
+}
+
+// path returns the file of the blob with the hex SHA-256 hash.
+func (b *blobStore) path(hash string) (string, error) {
+	if !sha256Hex.MatchString(hash) {
+		return "", errInvalidDigest
+	}
+	return filepath.Join(b.dir, hash), nil
+}
+
+func (b *blobStore) has(hash string, size int64) bool {
+	path, err := b.path(hash)
+	if err != nil {
+		return false
+	}
+	info, err := os.Stat(path)
+	return err == nil && info.Size() == size
+}
+
+// put stores content after verifying it against hash. Concurrent uploads of
+// the same content all succeed.
+func (b *blobStore) put(hash string, content []byte) error {
+	path, err := b.path(hash)
+	if err != nil {
+		return err
+	}
+	sum := sha256.Sum256(content)
+	if hex.EncodeToString(sum[:]) != hash {
+		return errDigestMismatch
+	}
+	if b.has(hash, int64(len(content))) {
+		return nil
+	}
+
+	tmp, err := ioutil.TempFile(b.dir, hash+".tmp")
+	if err != nil {
+		return err
+	}
+	if _, err := tmp.Write(content); err != nil {
+		tmp.Close()
+		os.Remove(tmp.Name())
+		return err
+	}
+	if err := tmp.Close(); err != nil {
+		os.Remove(tmp.Name())
+		return err
+	}
+	return os.Rename(tmp.Name(), path)
+}
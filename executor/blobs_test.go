@@ -0,0 +1,46 @@
+package main
+
+import (
+	"crypto/sha256"
+	"encoding/hex"
+	"io/ioutil"
+	"os"
+	"testing"
+)
+
+func TestBlobStore(t *testing.T) {
+	dir, err := ioutil.TempDir("", "blobs")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	blobs, err := newBlobStore(dir)
+	if err != nil {
+		t.Fatal(err)
+	}
+
+	content := []byte("int main() { return 0; }\n")
+	sum := sha256.Sum256(content)
+	hash := hex.EncodeToString(sum[:])
+	if blobs.has(hash, int64(len(content))) {
+		t.Error("empty store has blob")
+	}
+	for i := 0; i < 2; i++ {
+		if err := blobs.put(hash, content); err != nil {
+			t.Fatal(err)
+		}
+	}
+	if !blobs.has(hash, int64(len(content))) {
+		t.Error("store misses uploaded blob")
+	}
+	if files, _ := ioutil.ReadDir(dir); len(files) != 1 {
+		t.Errorf("store has %d files, want 1", len(files))
+	}
+
+	if err := blobs.put(hash, []byte("other")); err != errDigestMismatch {
+		t.Errorf("put() with wrong content = %v, want %v", err, errDigestMismatch)
+	}
+	if err := blobs.put("../escape", content); err != errInvalidDigest {
+		t.Errorf("put() with invalid digest = %v, want %v", err, errInvalidDigest)
+	}
+}
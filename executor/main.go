@@ -0,0 +1,67 @@
+// Command executor is a stand-in for a remote compile executor. It serves the
+// Executor protocol of intercept.proto and runs the compilations as processes
+// on this machine, at most --workers at a time, the most costly first.
+//
+// Only the --compilers are run, but with arguments of the client's choice, so
+// the executor listens on loopback addresses unless --allow_remote is given.
+package main
+
+import (
+	"flag"
+	"log"
+	"net"
+	"os"
+	"path/filepath"
+	"runtime"
+	"strings"
+
+	pb "gitlab.com/code-intelligence/core/build_system/proto"
+	"google.golang.org/grpc"
+)
+
+var (
+	address  = flag.String("address", "localhost:6775", "The address to listen on")
+	workers  = flag.Int("workers", runtime.NumCPU(), "The number of compilations to run in parallel")
+	cacheDir = flag.String("cache_dir", filepath.Join(os.TempDir(), "intercept_executor"), "The directory for uploaded inputs and compilations")
+
+	compilerNames = flag.String("compilers", "cc,c++,gcc,g++,clang,clang++", "Comma-separated compilers clients may run, looked up in PATH unless they contain a slash")
+	allowRemote   = flag.Bool("allow_remote", false, "Listen on addresses other than loopback; only do this on a trusted network")
+)
+
+func main() {
+	flag.Parse()
+	if *workers < 1 {
+		log.Fatalf("--workers must be positive, got %d", *workers)
+	}
+	if err := checkListenAddress(*address); err != nil && !*allowRemote {
+		log.Fatalf("Refusing to listen on %s without --allow_remote: %v", *address, err)
+	}
+	allowed, err := newCompilers(strings.Split(*compilerNames, ","))
+	if err != nil {
+		log.Fatalf("--compilers=%s: %v", *compilerNames, err)
+	}
+
+	blobs, err := newBlobStore(filepath.Join(*cacheDir, "blobs"))
+	if err != nil {
+		log.Fatal(err)
+	}
+	workDir := filepath.Join(*cacheDir, "work")
+	if err := os.MkdirAll(workDir, 0755); err != nil {
+		log.Fatal(err)
+	}
+
+	listener, err := net.Listen("tcp", *address)
+	if err != nil {
+		log.Fatal(err)
+	}
+	// preprocessed sources easily exceed the default limit of 4 MB
+	rpcServer := grpc.NewServer(grpc.MaxRecvMsgSize(256 << 20))
+	pb.RegisterExecutorServer(rpcServer, &executorService{
+		blobs:     blobs,
+		scheduler: newScheduler(*workers),
+		compilers: allowed,
+		workDir:   workDir,
+	})
+	log.Printf("Executing compilations on %d workers at %s", *workers, *address)
+	log.Fatal(rpcServer.Serve(listener))
+}
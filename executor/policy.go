@@ -0,0 +1,62 @@
+package main
+
+import (
+	"errors"
+	"fmt"
+	"net"
+	"os/exec"
+	"path/filepath"
+)
+
+var errNoCompilers = errors.New("none of the allowed compilers was found")
+
+// compilers are the executables actions may run, by the base name clients
+// request them with. Clients never choose a path on this machine.
+type compilers map[string]string
+
+// newCompilers resolves names, which are looked up in PATH unless they
+// contain a slash. Names that do not resolve are skipped.
+func newCompilers(names []string) (compilers, error) {
+	c := make(compilers)
+	for _, name := range names {
+		if name == "" {
+			continue
+		}
+		path, err := exec.LookPath(name)
+		if err != nil {
+			continue
+		}
+		if path, err = filepath.Abs(path); err != nil {
+			return nil, err
+		}
+		c[filepath.Base(name)] = path
+	}
+	if len(c) == 0 {
+		return nil, errNoCompilers
+	}
+	return c, nil
+}
+
+// resolve returns the executable for the compiler a client requested, e.g.
+// "g++" or "/usr/bin/g++", or false if it is not allowed.
+func (c compilers) resolve(requested string) (string, bool) {
+	path, ok := c[filepath.Base(requested)]
+	return path, ok
+}
+
+// checkListenAddress fails unless address is on a loopback interface:
+// whoever can connect runs the allowed compilers with arguments of their
+// choice, which is as good as running commands on this machine.
+func checkListenAddress(address string) error {
+	host, _, err := net.SplitHostPort(address)
+	if err != nil {
+		return err
+	}
+	if host == "localhost" {
+		return nil
+	}
+	if ip := net.ParseIP(host); ip != nil && ip.IsLoopback() {
+		return nil
+	}
+	return fmt.Errorf("%q is not a loopback address", address)
+}
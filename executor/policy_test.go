@@ -0,0 +1,51 @@
+package main
+
+import (
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"testing"
+)
+
+func TestCompilers(t *testing.T) {
+	dir, err := ioutil.TempDir("", "compilers")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	compiler := filepath.Join(dir, "cc")
+	if err := ioutil.WriteFile(compiler, []byte("#!/bin/sh\n"), 0755); err != nil {
+		t.Fatal(err)
+	}
+
+	if _, err := newCompilers([]string{filepath.Join(dir, "missing")}); err != errNoCompilers {
+		t.Errorf("got %v for missing compilers, want %v", err, errNoCompilers)
+	}
+	allowed, err := newCompilers([]string{compiler, filepath.Join(dir, "missing")})
+	if err != nil {
+		t.Fatal(err)
+	}
+	for _, requested := range []string{"cc", "/usr/bin/cc", "../cc"} {
+		if path, ok := allowed.resolve(requested); !ok || path != compiler {
+			t.Errorf("resolve(%q) = %q, %v, want %q", requested, path, ok, compiler)
+		}
+	}
+	for _, requested := range []string{"missing", "sh", "/bin/sh", ""} {
+		if path, ok := allowed.resolve(requested); ok {
+			t.Errorf("resolve(%q) = %q, want not allowed", requested, path)
+		}
+	}
+}
+
+func TestCheckListenAddress(t *testing.T) {
+	for _, address := range []string{"localhost:6775", "127.0.0.1:6775", "127.1.2.3:0", "[::1]:6775"} {
+		if err := checkListenAddress(address); err != nil {
+			t.Errorf("%s: %v", address, err)
+		}
+	}
+	for _, address := range []string{":6775", "0.0.0.0:6775", "[::]:6775", "10.0.0.1:6775", "example.com:6775", "localhost"} {
+		if err := checkListenAddress(address); err == nil {
+			t.Errorf("%s is accepted", address)
+		}
+	}
+}
@@ -0,0 +1,105 @@
+package main
+
+import (
+	"container/heap"
+	"context"
+	"sync"
+)
+
+// scheduler runs tasks on a fixed number of workers. Waiting tasks are
+// started in the order of decreasing estimated cost, so long compilations do
+// not end up last and idle all other workers. Tasks of equal cost start in
+// the order they arrived.
+type scheduler struct {
+	mu      sync.Mutex
+	free    int
+	waiting taskQueue
+	arrived int64
+}
+
+type task struct {
+	cost    int64
+	arrival int64
+	start   chan struct{}
+	index   int
+}
+
+func newScheduler(workers int) *scheduler {
+	return &scheduler{free: workers}
+}
+
+// run calls f on a worker once all more costly tasks have started. It returns
+// ctx.Err() without calling f if ctx is done before.
+func (s *scheduler) run(ctx context.Context, cost int64, f func()) error {
+	s.mu.Lock()
+	if s.free > 0 && len(s.waiting) == 0 {
+		s.free--
+		s.mu.Unlock()
+	} else {
+		t := &task{cost: cost, arrival: s.arrived, start: make(chan struct{})}
+		s.arrived++
+		heap.Push(&s.waiting, t)
+		s.mu.Unlock()
+
+		select {
+		case <-t.start:
+		case <-ctx.Done():
+			s.mu.Lock()
+			if t.index >= 0 {
+				heap.Remove(&s.waiting, t.index)
+				s.mu.Unlock()
+				return ctx.Err()
+			}
+			// started concurrently, hand the worker on
+			s.mu.Unlock()
+			s.release()
+			return ctx.Err()
+		}
+	}
+
+	defer s.release()
+	f()
+	return nil
+}
+
+func (s *scheduler) release() {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	if len(s.waiting) == 0 {
+		s.free++
+		return
+	}
+	close(heap.Pop(&s.waiting).(*task).start)
+}
+
+// taskQueue is a max-heap of tasks by cost.
+type taskQueue []*task
+
+func (q taskQueue) Len() int { return len(q) }
+
+func (q taskQueue) Less(i, j int) bool {
+	if q[i].cost != q[j].cost {
+		return q[i].cost > q[j].cost
+	}
+	return q[i].arrival < q[j].arrival
+}
+
+func (q taskQueue) Swap(i, j int) {
+	q[i], q[j] = q[j], q[i]
+	q[i].index = i
+	q[j].index = j
+}
+
+func (q *taskQueue) Push(x interface{}) {
+	t := x.(*task)
+	t.index = len(*q)
+	*q = append(*q, t)
+}
+
+func (q *taskQueue) Pop() interface{} {
+	old := *q
+	t := old[len(old)-1]
+	t.index = -1
+	*q = old[:len(old)-1]
+	return t
+}
@@ -0,0 +1,82 @@
+package main
+
+import (
+	"context"
+	"reflect"
+	"sync"
+	"testing"
+	"time"
+)
+
+func TestSchedulerStartsCostlyTasksFirst(t *testing.T) {
+	s := newScheduler(1)
+	block := make(chan struct{})
+	started := make(chan struct{})
+	go s.run(context.Background(), 0, func() {
+		close(started)
+		<-block
+	})
+	<-started
+
+	var (
+		mu    sync.Mutex
+		order []int64
+		wg    sync.WaitGroup
+	)
+	for _, cost := range []int64{1, 5, 3, 5} {
+		wg.Add(1)
+		go func(cost int64) {
+			defer wg.Done()
+			s.run(context.Background(), cost, func() {
+				mu.Lock()
+				order = append(order, cost)
+				mu.Unlock()
+			})
+		}(cost)
+	}
+	// wait until all tasks are queued behind the blocking one
+	for {
+		s.mu.Lock()
+		n := len(s.waiting)
+		s.mu.Unlock()
+		if n == 4 {
+			break
+		}
+		time.Sleep(time.Millisecond)
+	}
+	close(block)
+	wg.Wait()
+
+	if want := []int64{5, 5, 3, 1}; !reflect.DeepEqual(order, want) {
+		t.Errorf("ran tasks with costs %v, want %v", order, want)
+	}
+	if s.free != 1 {
+		t.Errorf("%d free workers after all tasks, want 1", s.free)
+	}
+}
+
+func TestSchedulerCancelsWaitingTasks(t *testing.T) {
+	s := newScheduler(1)
+	block := make(chan struct{})
+	started := make(chan struct{})
+	go s.run(context.Background(), 0, func() {
+		close(started)
+		<-block
+	})
+	<-started
+
+	ctx, cancel := context.WithCancel(context.Background())
+	cancel()
+	ran := false
+	if err := s.run(ctx, 1, func() { ran = true }); err != context.Canceled {
+		t.Errorf("run() = %v, want %v", err, context.Canceled)
+	}
+	if ran || len(s.waiting) != 0 {
+		t.Error("canceled task ran or is still waiting")
+	}
+
+	close(block)
+	if err := s.run(context.Background(), 1, func() { ran = true }); err != nil || !ran {
+		t.Errorf("run() after release = %v, ran %v", err, ran)
+	}
+}
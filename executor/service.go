@@ -0,0 +1,124 @@
+package main
+
+import (
+	"bytes"
+	"context"
+	"io/ioutil"
+	"os"
+	"os/exec"
+	"path/filepath"
+	"syscall"
+
+	pb "gitlab.com/code-intelligence/core/build_system/proto"
+	"google.golang.org/grpc/codes"
+	"google.golang.org/grpc/status"
+)
+
+// executorService compiles actions in processes on this machine.
+type executorService struct {
+	blobs     *blobStore
+	scheduler *scheduler
+	compilers compilers
+	workDir   string
+}
+
+func (s *executorService) FindMissingBlobs(ctx context.Context,
+	req *pb.FindMissingBlobsRequest) (*pb.FindMissingBlobsResponse, error) {
+
+	res := new(pb.FindMissingBlobsResponse)
+	for _, digest := range req.Digests {
+		if !s.blobs.has(digest.Sha256, digest.Size) {
+			res.Missing = append(res.Missing, digest)
+		}
+	}
+	return res, nil
+}
+
+func (s *executorService) UploadBlobs(ctx context.Context,
+	req *pb.UploadBlobsRequest) (*pb.Status, error) {
+
+	res := new(pb.Status)
+	for _, blob := range req.Blobs {
+		res.Received++
+		if blob.Digest == nil {
+			return res, status.Error(codes.InvalidArgument, "blob without digest")
+		}
+		if err := s.blobs.put(blob.Digest.Sha256, blob.Content); err != nil {
+			return res, status.Errorf(codes.InvalidArgument, "blob %s: %v", blob.Digest.Sha256, err)
+		}
+		res.Processed++
+	}
+	return res, nil
+}
+
+func (s *executorService) Execute(ctx context.Context,
+	req *pb.CompileAction) (*pb.CompileResult, error) {
+
+	if len(req.Arguments) == 0 || req.Input == nil {
+		return nil, status.Error(codes.InvalidArgument, "action without arguments or input")
+	}
+	compiler, ok := s.compilers.resolve(req.Arguments[0])
+	if !ok {
+		return nil, status.Errorf(codes.PermissionDenied, "compiler %q is not allowed", req.Arguments[0])
+	}
+	if !s.blobs.has(req.Input.Sha256, req.Input.Size) {
+		return nil, status.Errorf(codes.FailedPrecondition, "input %s was not uploaded", req.Input.Sha256)
+	}
+
+	var (
+		res *pb.CompileResult
+		err error
+	)
+	if schedErr := s.scheduler.run(ctx, req.EstimatedCost, func() {
+		res, err = s.compile(ctx, compiler, req)
+	}); schedErr != nil {
+		return nil, status.Error(codes.Canceled, schedErr.Error())
+	}
+	return res, err
+}
+
+// compile runs the action with compiler in a directory of its own.
+func (s *executorService) compile(ctx context.Context, compiler string, req *pb.CompileAction) (*pb.CompileResult, error) {
+	dir, err := ioutil.TempDir(s.workDir, "action")
+	if err != nil {
+		return nil, status.Error(codes.Internal, err.Error())
+	}
+	defer os.RemoveAll(dir)
+
+	blob, _ := s.blobs.path(req.Input.Sha256)
+	input := filepath.Join(dir, "input"+filepath.Base(req.InputSuffix))
+	if err := os.Symlink(blob, input); err != nil {
+		return nil, status.Error(codes.Internal, err.Error())
+	}
+	object := filepath.Join(dir, "output.o")
+
+	var stdout, stderr bytes.Buffer
+	args := append([]string{}, req.Arguments[1:]...)
+	if filepath.IsAbs(req.Directory) {
+		// debug information names the client's directory, not this one
+		args = append(args, "-fdebug-prefix-map="+dir+"="+req.Directory)
+	}
+	args = append(args, input, "-o", object)
+	cmd := exec.CommandContext(ctx, compiler, args...)
+	cmd.Dir = dir
+	cmd.Stdout = &stdout
+	cmd.Stderr = &stderr
+
+	res := new(pb.CompileResult)
+	if err := cmd.Run(); err != nil {
+		exitErr, ok := err.(*exec.ExitError)
+		if !ok {
+			// the compiler is missing here, the client compiles locally
+			return nil, status.Error(codes.FailedPrecondition, err.Error())
+		}
+		res.ExitCode = int32(exitErr.Sys().(syscall.WaitStatus).ExitStatus())
+	}
+	res.StandardOutput = stdout.Bytes()
+	res.StandardError = stderr.Bytes()
+	if res.ExitCode == 0 {
+		if res.Object, err = ioutil.ReadFile(object); err != nil {
+			return nil, status.Error(codes.Internal, err.Error())
+		}
+	}
+	return res, nil
+}
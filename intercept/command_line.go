@@ -1,34 +1,10 @@
 package main
 
 import (
-	"path"
-
 	"gitlab.com/code-intelligence/core/build_system/proto"
+	"gitlab.com/code-intelligence/core/build_system/types"
 )
 
-var inputSuffixes = map[string]struct{}{
-	".c":   {},
-	".i":   {},
-	".ii":  {},
-	".m":   {},
-	".mi":  {},
-	".mm":  {},
-	".mii": {},
-	".C":   {},
-	".cc":  {},
-	".CC":  {},
-	".cp":  {},
-	".cpp": {},
-	".cxx": {},
-	".c++": {},
-	".C++": {},
-	".txx": {},
-	".s":   {},
-	".S":   {},
-	".sx":  {},
-	".asm": {},
-}
-
 func commandLineFromInterceptedCommand(cmd *proto.InterceptedCommand) *commandLine {
 	result := new(commandLine)
 	outputFollows := false
@@ -42,7 +18,7 @@ func commandLineFromInterceptedCommand(cmd *proto.InterceptedCommand) *commandLi
 			result.outputFile = arg
 			continue
 		}
-		if _, found := inputSuffixes[path.Ext(arg)]; found {
+		if types.IsInputFile(arg) {
 			result.inputFiles = append(result.inputFiles, arg)
 		}
 	}
@@ -1,6 +1,7 @@
 package main
 
 import (
+	"bytes"
 	"encoding/json"
 	"flag"
 	"fmt"
@@ -9,11 +10,17 @@ import (
 	"net"
 	"os"
 	"os/exec"
+	"path"
+	"path/filepath"
 	"strings"
 
 	"github.com/spf13/pflag"
 	"github.com/spf13/viper"
+	"gitlab.com/code-intelligence/core/build_system/compile_db/compiledb"
 	"gitlab.com/code-intelligence/core/build_system/intercept/internal/config"
+	"gitlab.com/code-intelligence/core/build_system/intercept/internal/pch"
+	"gitlab.com/code-intelligence/core/build_system/intercept/internal/stats"
+	"gitlab.com/code-intelligence/core/build_system/intercept/internal/store"
 	pb "gitlab.com/code-intelligence/core/build_system/proto"
 	"gitlab.com/code-intelligence/core/build_system/types"
 	pathUtil "gitlab.com/code-intelligence/core/utils/pathutils"
@@ -22,6 +29,7 @@ import (
 
 func usage() {
 	fmt.Printf("Usage: %s [OPTIONS] BUILD_COMMAND ...\n", os.Args[0])
+	fmt.Printf("       %s [OPTIONS] --%s\n", os.Args[0], config.ShowStatsFlag)
 	pflag.PrintDefaults()
 }
 
@@ -32,27 +40,37 @@ func main() {
 	viper.BindPFlags(pflag.CommandLine)
 
 	buildCmd := pflag.Args()
+	settings := config.InterceptSettings()
+	statsFile := viper.GetString(config.StatsFileFlag)
+	if viper.GetBool(config.ShowStatsFlag) {
+		if err := printStats(statsFile, settings); err != nil {
+			log.Fatal(err)
+		}
+		return
+	}
 
 	if len(buildCmd) == 0 {
 		pflag.Usage()
 		os.Exit(1)
 	}
+	if viper.GetBool(config.CompactCompilationDbFlag) && viper.GetBool(config.BinaryCompilationDbFlag) {
+		log.Fatalf("--%s and --%s cannot be combined", config.CompactCompilationDbFlag, config.BinaryCompilationDbFlag)
+	}
 
-	service := newInterceptorService()
+	service := newInterceptorService(settings)
 
 	if err := serve(service); err != nil {
 		log.Fatal(err)
 	}
 
-	var interceptedCommands []*pb.InterceptedCommand
 	go func() {
 		for c := range service.interceptedCommands {
+			c = service.store.Command(service.store.Add(c))
 			originalCmd := strings.Join(c.OriginalArguments, " ")
 			replacedCmd := strings.Join(c.ReplacedArguments, " ")
 			fmt.Printf("Original Command:\n%s\n", originalCmd)
 			fmt.Printf("Replaced Command:\n%s\n", replacedCmd)
 			fmt.Println("---------------------------------")
-			interceptedCommands = append(interceptedCommands, c)
 		}
 	}()
 
@@ -65,41 +83,178 @@ func main() {
 
 	env = append(env, fmt.Sprintf("LD_PRELOAD=%s", preloadLibPath))
 	env = append(env, "REPORT_URL="+config.ServerAddr)
-	env = append(env, "INTERCEPT_SETTINGS="+config.InterceptSettings().String())
+
+	// the answers are shared by the processes of this build only, and the
+	// directory is removed explicitly since log.Fatal skips deferred calls
+	var probeDir string
+	if viper.GetBool(config.CacheProbesFlag) {
+		if probeDir, err = ioutil.TempDir("", "intercept_probes"); err != nil {
+			log.Fatalf("Failed to create probe cache: %v", err)
+		}
+		settings.ProbeCacheDir = probeDir
+	}
+	env = append(env, "INTERCEPT_SETTINGS="+settings.String())
+
+	// statistics are diagnostics only, the build runs without them
+	hookStats, err := stats.Create(statsFile)
+	if err != nil {
+		log.Printf("Warning: Not collecting statistics, failed to create %q: %v", statsFile, err)
+	} else {
+		env = append(env, "INTERCEPT_STATS="+statsFile)
+	}
+
 	cmd := exec.Command(buildCmd[0], buildCmd[1:]...)
 	cmd.Env = env
 	out, err := cmd.CombinedOutput()
+	if probeDir != "" {
+		os.RemoveAll(probeDir)
+	}
 	log.Print("out:\n", string(out))
+	if hookStats != nil {
+		snapshot := hookStats.Snapshot()
+		snapshot.Print(os.Stdout, ruleNames(settings))
+		hookStats.Close()
+		os.Remove(statsFile)
+	}
 	if err != nil {
 		log.Fatal("command crashed: ", err)
 	}
 
-	if viper.GetBool("create_compiler_db") {
-		commands := createCompilationDb(interceptedCommands)
-		out, err := json.MarshalIndent(commands, "", "    ")
-		if err != nil {
+	if viper.GetBool(config.CompilationDbFlag) {
+		if err := writeCompilationDb(service.store.Commands()); err != nil {
 			panic(err)
 		}
-		err = ioutil.WriteFile(config.CompilerDbPath, out, 0755)
-		if err != nil {
-			panic(err)
+	}
+
+	if planFile := viper.GetString(config.PlanPchFlag); planFile != "" {
+		if err := writePchPlan(planFile, service.store.Commands()); err != nil {
+			log.Fatalf("Failed to plan precompiled headers: %v", err)
 		}
 	}
 }
 
+// writePchPlan plans precompiled headers for the intercepted commands and
+// writes the plan in text format, to be used by a later build with --use_pch.
+func writePchPlan(planFile string, commands []*pb.InterceptedCommand) error {
+	headerDir, err := filepath.Abs(viper.GetString(config.PchDirFlag))
+	if err != nil {
+		return err
+	}
+	plan, err := pch.Plan(commands, headerDir, viper.GetInt(config.PchMinGroupSizeFlag))
+	if err != nil {
+		return err
+	}
+	log.Printf("Planned %d precompiled headers in %s", len(plan.Headers), planFile)
+	return ioutil.WriteFile(planFile, []byte(plan.String()), 0644)
+}
+
+// writeCompilationDb writes the compilation database in the format chosen by
+// the flags.
+func writeCompilationDb(commands []*pb.InterceptedCommand) error {
+	var (
+		dbPath = config.CompilerDbPath
+		out    []byte
+		err    error
+	)
+	switch {
+	case viper.GetBool(config.BinaryCompilationDbFlag):
+		var buf bytes.Buffer
+		dbPath = config.BinaryCompilerDbPath
+		err = compiledb.Write(&buf, createCompilationDb(commands))
+		out = buf.Bytes()
+	case viper.GetBool(config.CompactCompilationDbFlag):
+		dbPath = config.CompactCompilerDbPath
+		out, err = json.Marshal(createCompactCompilationDb(commands))
+	default:
+		out, err = json.MarshalIndent(createCompilationDb(commands), "", "    ")
+	}
+	if err != nil {
+		return err
+	}
+	return ioutil.WriteFile(dbPath, out, 0755)
+}
+
 func createCompilationDb(cmds []*pb.InterceptedCommand) (res []types.CompilationCommand) {
 	for _, cmd := range cmds {
 		log.Printf("cmd: %+v", cmd)
 		cl := commandLineFromInterceptedCommand(cmd)
 		for _, inputFile := range cl.inputFiles {
 			res = append(res, types.CompilationCommand{
-				Arguments: cmd.ReplacedArguments,
-				Directory: cmd.Directory,
-				Output:    cl.outputFile,
-				File:      inputFile,
+				Arguments:    cmd.ReplacedArguments,
+				Directory:    cmd.Directory,
+				Output:       cl.outputFile,
+				File:         inputFile,
+				Dependencies: existingFiles(cmd.FileDependencies),
+			})
+		}
+
+	}
+	return res
+}
+
+// createCompactCompilationDb creates a compilation database whose strings and
+// argument lists are stored once and referenced by index.
+func createCompactCompilationDb(cmds []*pb.InterceptedCommand) *types.CompactCompilationDb {
+	var (
+		strs      store.Strings
+		arguments store.Vectors
+		res       = &types.CompactCompilationDb{Commands: []types.CompactCompilationCommand{}}
+	)
+	for _, cmd := range cmds {
+		cl := commandLineFromInterceptedCommand(cmd)
+		if len(cl.inputFiles) == 0 {
+			continue
+		}
+		args := make([]uint32, len(cmd.ReplacedArguments))
+		for i, arg := range cmd.ReplacedArguments {
+			args[i] = strs.Intern(arg)
+		}
+		argsID := arguments.Intern(args)
+		var deps []uint32
+		for _, dep := range existingFiles(cmd.FileDependencies) {
+			deps = append(deps, strs.Intern(dep))
+		}
+		for _, inputFile := range cl.inputFiles {
+			res.Commands = append(res.Commands, types.CompactCompilationCommand{
+				Arguments:    argsID,
+				Directory:    strs.Intern(cmd.Directory),
+				Output:       strs.Intern(cl.outputFile),
+				File:         strs.Intern(inputFile),
+				Dependencies: deps,
 			})
 		}
+	}
+	res.Strings = strs.Values()
+	res.Arguments = arguments.Values()
+	return res
+}
+
+// printStats prints the statistics of the build using statsFile, which may
+// still be running.
+func printStats(statsFile string, settings *pb.InterceptSettings) error {
+	hookStats, err := stats.Open(statsFile)
+	if err != nil {
+		return err
+	}
+	defer hookStats.Close()
+	snapshot := hookStats.Snapshot()
+	return snapshot.Print(os.Stdout, ruleNames(settings))
+}
 
+func ruleNames(settings *pb.InterceptSettings) (names []string) {
+	for i, rule := range settings.MatchingRules {
+		names = append(names, fmt.Sprintf("rule %d (%s)", i, path.Base(rule.ReplaceCommand)))
+	}
+	return names
+}
+
+// existingFiles drops the files that no longer exist after the build, which
+// are the temporary files passed between the processes of a compiler.
+func existingFiles(files []string) (res []string) {
+	for _, file := range files {
+		if _, err := os.Stat(file); err == nil {
+			res = append(res, file)
+		}
 	}
 	return res
 }
@@ -5,16 +5,22 @@ import (
 
 	"github.com/spf13/viper"
 
+	"gitlab.com/code-intelligence/core/build_system/intercept/internal/store"
 	pb "gitlab.com/code-intelligence/core/build_system/proto"
 )
 
 type interceptorService struct {
 	interceptedCommands chan *pb.InterceptedCommand
+	store               *store.Store
 }
 
-func newInterceptorService() *interceptorService {
+// newInterceptorService creates a service that stores reported commands.
+// settings have to be the settings passed to the intercepted processes, as
+// their reports are encoded against them.
+func newInterceptorService(settings *pb.InterceptSettings) *interceptorService {
 	s := new(interceptorService)
 	s.interceptedCommands = make(chan *pb.InterceptedCommand)
+	s.store = store.New(settings)
 	return s
 }
 
@@ -42,3 +48,10 @@ func (s *interceptorService) ReportInterceptedCommand(ctx context.Context,
 	s.interceptedCommands <- req
 	return &pb.Status{}, nil
 }
+
+func (s *interceptorService) ReportFileDependencies(ctx context.Context,
+	req *pb.FileDependencies) (*pb.Status, error) {
+
+	s.store.AddFileDependencies(req)
+	return &pb.Status{}, nil
+}
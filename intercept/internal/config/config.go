@@ -5,6 +5,7 @@ import (
 
 	"log"
 
+	"os"
 	"path/filepath"
 
 	"github.com/spf13/pflag"
@@ -14,10 +15,23 @@ import (
 
 const (
 	// ServerAddr is the address for the server to listen on.
-	ServerAddr        = "localhost:6774"
-	CompilerDbPath    = "compile_commands.json"
-	CompilationDbFlag = "create_compiler_db"
-	ccMatchCommand    = `^([^-]*-)*[mg]cc(-\d+(\.\d+){0,2})?$|` +
+	ServerAddr               = "localhost:6774"
+	CompilerDbPath           = "compile_commands.json"
+	CompactCompilerDbPath    = "compile_commands.compact.json"
+	BinaryCompilerDbPath     = "compile_commands.bin"
+	CompilationDbFlag        = "create_compiler_db"
+	CompactCompilationDbFlag = "compact_compiler_db"
+	BinaryCompilationDbFlag  = "binary_compiler_db"
+	TrackDependenciesFlag    = "track_dependencies"
+	StatsFileFlag            = "stats_file"
+	ShowStatsFlag            = "show_stats"
+	PlanPchFlag              = "plan_pch"
+	UsePchFlag               = "use_pch"
+	PchDirFlag               = "pch_dir"
+	PchMinGroupSizeFlag      = "pch_min_group_size"
+	RemoteExecutorFlag       = "remote_executor"
+	CacheProbesFlag          = "cache_probes"
+	ccMatchCommand           = `^([^-]*-)*[mg]cc(-\d+(\.\d+){0,2})?$|` +
 		`^([^-]*-)*clang(-\d+(\.\d+){0,2})?$|` +
 		`^(|i)cc$|^(g|)xlc$`
 	cxxMatchCommand = `^([^-]*-)*[cmg]\+\+(-\d+(\.\d+){0,2})?$|` +
@@ -116,6 +130,17 @@ func setDefaultValues() {
 	viper.SetDefault("sanitizer", "address")
 
 	pflag.Bool(CompilationDbFlag, false, "Whether to create compilation database")
+	pflag.Bool(CompactCompilationDbFlag, false, "Whether to write the compilation database with interned strings; excludes --"+BinaryCompilationDbFlag)
+	pflag.Bool(BinaryCompilationDbFlag, false, "Whether to write the compilation database in the indexed binary format; excludes --"+CompactCompilationDbFlag)
+	pflag.Bool(TrackDependenciesFlag, false, "Whether to record the files read by each replaced command")
+	pflag.String(StatsFileFlag, defaultStatsFile(), "The file shared with intercepted processes for statistics")
+	pflag.Bool(ShowStatsFlag, false, "Print the statistics of the running build instead of building")
+	pflag.String(PlanPchFlag, "", "The file to write a plan of precompiled headers for the build to")
+	pflag.String(UsePchFlag, "", "The plan of precompiled headers to use for the build")
+	pflag.String(PchDirFlag, ".intercept_pch", "The directory for planned and precompiled headers")
+	pflag.Int(PchMinGroupSizeFlag, 4, "The minimum number of sources sharing a precompiled header")
+	pflag.Bool(CacheProbesFlag, false, "Whether to answer repeated compiler queries such as --version from a cache")
+	pflag.String(RemoteExecutorFlag, "", "The address of an executor to compile replaced commands on")
 	pflag.String("match_cc", "", "Override default cc match command")
 	pflag.String("match_cxx", "", "Override default cxx match command")
 	pflag.String("replace_cc", "", "The command to replace the C compiler with")
@@ -124,6 +149,19 @@ func setDefaultValues() {
 	pflag.String("sanitizer", "", "Whether a specific sanitizer config should be used")
 }
 
+// defaultStatsFile returns a path private to the user, in shared memory if
+// available.
+func defaultStatsFile() string {
+	dir := os.Getenv("XDG_RUNTIME_DIR")
+	if dir == "" {
+		dir = "/dev/shm"
+		if _, err := os.Stat(dir); err != nil {
+			dir = os.TempDir()
+		}
+	}
+	return filepath.Join(dir, fmt.Sprintf("intercept_stats-%d", os.Getuid()))
+}
+
 // Merge defaults into the config.
 func merge(defaults map[string][]string, config stringMap) (merged stringMap) {
 	merged = make(stringMap)
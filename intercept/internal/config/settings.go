@@ -4,6 +4,7 @@ import (
 	"fmt"
 
 	"os"
+	"path/filepath"
 
 	"log"
 
@@ -47,18 +48,29 @@ func InterceptSettings() *proto.InterceptSettings {
 		}
 	}
 
+	pchPlan := viper.GetString(UsePchFlag)
+	if pchPlan != "" {
+		if abs, err := filepath.Abs(pchPlan); err == nil {
+			pchPlan = abs
+		}
+	}
+
 	return &proto.InterceptSettings{
 		MatchingRules: []*proto.MatchingRule{{
 			MatchCommand:    viper.GetString("match_cc"),
 			ReplaceCommand:  replaceCC,
 			AddArguments:    addArgs,
 			RemoveArguments: removeArgs,
+			RemoteExecutor:  viper.GetString(RemoteExecutorFlag),
 		}, {
 			MatchCommand:    viper.GetString("match_cxx"),
 			ReplaceCommand:  replaceCXX,
 			AddArguments:    addArgs,
 			RemoveArguments: removeArgs,
+			RemoteExecutor:  viper.GetString(RemoteExecutorFlag),
 		}},
+		TrackFileDependencies: viper.GetBool(TrackDependenciesFlag),
+		PrecompiledHeaderPlan: pchPlan,
 	}
 }
 
@@ -0,0 +1,196 @@
+// Package pch plans precompiled headers for groups of compilations that share
+// their arguments, their directory and the first includes of their sources.
+// The replacer library builds and uses the planned headers; the argument and
+// include normalization here mirrors replacer/precompiled_header.cc.
+package pch
+
+import (
+	"bufio"
+	"bytes"
+	"crypto/sha1"
+	"encoding/hex"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"sort"
+	"strings"
+
+	pb "gitlab.com/code-intelligence/core/build_system/proto"
+	"gitlab.com/code-intelligence/core/build_system/types"
+)
+
+const maxIncludes = 64
+
+type group struct {
+	header   *pb.PrecompiledHeader
+	key      string
+	sources  int
+	includes []string
+}
+
+// Plan groups the compilations in cmds and writes a header with the common
+// include prefix of every group with at least minGroupSize sources into
+// headerDir. Headers whose content did not change are not rewritten, so
+// their precompiled headers stay fresh.
+func Plan(cmds []*pb.InterceptedCommand, headerDir string, minGroupSize int) (*pb.PrecompiledHeaderPlan, error) {
+	groups := make(map[string]*group)
+	for _, cmd := range cmds {
+		source, language, ok := compiledSource(cmd.ReplacedArguments)
+		if !ok {
+			continue
+		}
+		args := types.SharedArguments(cmd.ReplacedArguments)
+		key := strings.Join(append([]string{cmd.Directory, language}, args...), "\x00")
+		if !filepath.IsAbs(source) {
+			source = filepath.Join(cmd.Directory, source)
+		}
+		includes := ReadIncludePrefix(source)
+
+		g, found := groups[key]
+		if !found {
+			g = &group{
+				header: &pb.PrecompiledHeader{
+					Directory: cmd.Directory,
+					Arguments: args,
+					Language:  language,
+				},
+				key:      key,
+				includes: includes,
+			}
+			groups[key] = g
+		}
+		g.sources++
+		g.includes = commonPrefix(g.includes, includes)
+	}
+
+	if err := os.MkdirAll(headerDir, 0755); err != nil {
+		return nil, err
+	}
+	plan := new(pb.PrecompiledHeaderPlan)
+	for _, g := range groups {
+		if g.sources < minGroupSize || len(g.includes) == 0 {
+			continue
+		}
+		hash := sha1.Sum([]byte(g.key))
+		g.header.Includes = g.includes
+		g.header.Header = filepath.Join(headerDir, hex.EncodeToString(hash[:8])+".h")
+		if err := writeHeader(g.header); err != nil {
+			return nil, err
+		}
+		plan.Headers = append(plan.Headers, g.header)
+	}
+	sort.Slice(plan.Headers, func(i, j int) bool {
+		return plan.Headers[i].Header < plan.Headers[j].Header
+	})
+	return plan, nil
+}
+
+// ReadIncludePrefix reads the #include directives at the start of source,
+// up to the first line that is neither an include, blank nor a comment.
+// Quoted includes found next to source are returned as "absolute path", all
+// others as written.
+func ReadIncludePrefix(source string) (includes []string) {
+	f, err := os.Open(source)
+	if err != nil {
+		return nil
+	}
+	defer f.Close()
+
+	inComment := false
+	scanner := bufio.NewScanner(f)
+	for len(includes) < maxIncludes && scanner.Scan() {
+		text := strings.TrimSpace(scanner.Text())
+		if inComment {
+			end := strings.Index(text, "*/")
+			if end < 0 {
+				continue
+			}
+			inComment = false
+			text = strings.TrimSpace(text[end+2:])
+		}
+		if text == "" || strings.HasPrefix(text, "//") {
+			continue
+		}
+		if strings.HasPrefix(text, "/*") {
+			end := strings.Index(text[2:], "*/")
+			if end < 0 {
+				inComment = true
+				continue
+			}
+			if strings.TrimSpace(text[end+4:]) != "" {
+				break
+			}
+			continue
+		}
+
+		include, ok := parseInclude(text, filepath.Dir(source))
+		if !ok {
+			break
+		}
+		includes = append(includes, include)
+	}
+	return includes
+}
+
+func parseInclude(line, sourceDir string) (string, bool) {
+	if !strings.HasPrefix(line, "#") {
+		return "", false
+	}
+	line = strings.TrimLeft(line[1:], " \t")
+	if !strings.HasPrefix(line, "include") {
+		return "", false
+	}
+	line = strings.TrimLeft(line[len("include"):], " \t")
+	if line == "" || (line[0] != '<' && line[0] != '"') {
+		return "", false
+	}
+
+	closing := "\""
+	if line[0] == '<' {
+		closing = ">"
+	}
+	end := strings.Index(line[1:], closing)
+	if end < 0 {
+		return "", false
+	}
+	name := line[1 : end+1]
+	if closing == ">" {
+		return "<" + name + ">", true
+	}
+
+	local, err := filepath.EvalSymlinks(filepath.Join(sourceDir, name))
+	if err != nil {
+		return "\"" + name + "\"", true
+	}
+	return "\"" + local + "\"", true
+}
+
+func compiledSource(arguments []string) (source, language string, ok bool) {
+	sources, compiles := types.CompiledSources(arguments)
+	if !compiles || len(sources) != 1 {
+		return "", "", false
+	}
+	language = types.SourceLanguage(sources[0])
+	return sources[0], language, language != ""
+}
+
+func commonPrefix(a, b []string) []string {
+	n := 0
+	for n < len(a) && n < len(b) && a[n] == b[n] {
+		n++
+	}
+	return a[:n]
+}
+
+func writeHeader(header *pb.PrecompiledHeader) error {
+	var content bytes.Buffer
+	content.WriteString("// Generated by intercept for precompilation.\n")
+	for _, include := range header.Includes {
+		content.WriteString("#include " + include + "\n")
+	}
+
+	if old, err := ioutil.ReadFile(header.Header); err == nil && bytes.Equal(old, content.Bytes()) {
+		return nil
+	}
+	return ioutil.WriteFile(header.Header, content.Bytes(), 0644)
+}
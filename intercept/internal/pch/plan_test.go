@@ -0,0 +1,97 @@
+package pch
+
+import (
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"reflect"
+	"testing"
+
+	pb "gitlab.com/code-intelligence/core/build_system/proto"
+)
+
+func writeFile(t *testing.T, path, content string) {
+	if err := ioutil.WriteFile(path, []byte(content), 0644); err != nil {
+		t.Fatal(err)
+	}
+}
+
+func TestReadIncludePrefix(t *testing.T) {
+	dir, err := ioutil.TempDir("", "pch")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	writeFile(t, filepath.Join(dir, "local.h"), "")
+	writeFile(t, filepath.Join(dir, "a.cc"), `// header comment
+/* block
+   comment */
+#include <vector>
+#  include "local.h"
+#include "missing.h"
+
+int x;
+#include <map>
+`)
+
+	got := ReadIncludePrefix(filepath.Join(dir, "a.cc"))
+	want := []string{"<vector>", "\"" + filepath.Join(dir, "local.h") + "\"", "\"missing.h\""}
+	if !reflect.DeepEqual(got, want) {
+		t.Errorf("ReadIncludePrefix() = %q, want %q", got, want)
+	}
+}
+
+func TestPlan(t *testing.T) {
+	dir, err := ioutil.TempDir("", "pch")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	writeFile(t, filepath.Join(dir, "a.cc"), "#include <vector>\n#include <map>\n")
+	writeFile(t, filepath.Join(dir, "b.cc"), "#include <vector>\n#include <string>\n")
+	writeFile(t, filepath.Join(dir, "c.cc"), "#include <vector>\n")
+	writeFile(t, filepath.Join(dir, "d.cc"), "#include <string>\n")
+
+	compile := func(source string, flag string) *pb.InterceptedCommand {
+		return &pb.InterceptedCommand{
+			Directory:         dir,
+			ReplacedArguments: []string{"clang++", flag, "-c", source, "-o", source + ".o"},
+		}
+	}
+	cmds := []*pb.InterceptedCommand{
+		compile("a.cc", "-O2"),
+		compile("b.cc", "-O2"),
+		compile("c.cc", "-O2"),
+		// different arguments, separate group
+		compile("d.cc", "-O0"),
+		// links are not planned
+		{Directory: dir, ReplacedArguments: []string{"clang++", "-O2", "a.o", "b.o"}},
+	}
+
+	headerDir := filepath.Join(dir, "pch")
+	plan, err := Plan(cmds, headerDir, 3)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if len(plan.Headers) != 1 {
+		t.Fatalf("got %d headers, want 1", len(plan.Headers))
+	}
+	header := plan.Headers[0]
+	if header.Language != "c++" || header.Directory != dir {
+		t.Errorf("unexpected header %+v", header)
+	}
+	if want := []string{"clang++", "-O2", "-c"}; !reflect.DeepEqual(header.Arguments, want) {
+		t.Errorf("Arguments = %q, want %q", header.Arguments, want)
+	}
+	if want := []string{"<vector>"}; !reflect.DeepEqual(header.Includes, want) {
+		t.Errorf("Includes = %q, want %q", header.Includes, want)
+	}
+
+	content, err := ioutil.ReadFile(header.Header)
+	if err != nil {
+		t.Fatal(err)
+	}
+	if want := "// Generated by intercept for precompilation.\n#include <vector>\n"; string(content) != want {
+		t.Errorf("header content = %q, want %q", content, want)
+	}
+}
@@ -0,0 +1,189 @@
+// Package stats reads and writes the statistics segment shared with the
+// preload interceptor.
+package stats
+
+import (
+	"fmt"
+	"io"
+	"os"
+	"sync/atomic"
+	"syscall"
+	"text/tabwriter"
+	"time"
+	"unsafe"
+)
+
+// The layout constants of preload_interceptor/hook_stats.h.
+const (
+	magic          = 0x3153544154534349 // "ICSTATS1"
+	maxRules       = 16
+	latencyBuckets = 24
+)
+
+// StageNames are the names of the stages of an intercepted exec, in the order
+// of the HookStage enum.
+var StageNames = []string{"parse", "match", "resolve", "report"}
+
+// Histogram holds the latencies of one stage. Bucket i counts latencies
+// below 2^i microseconds that did not fit into bucket i - 1.
+type Histogram struct {
+	Count   uint64
+	TotalNs uint64
+	Buckets [latencyBuckets]uint64
+}
+
+// Snapshot is the content of the statistics segment. Its layout mirrors
+// HookStats of the preload interceptor.
+type Snapshot struct {
+	Magic                   uint64
+	HookedExecs             uint64
+	ReplacedExecs           uint64
+	ReportFailures          uint64
+	ReportDeadlinesExceeded uint64
+	RuleMatches             [maxRules]uint64
+	Stages                  [4]Histogram
+}
+
+// Segment is a mapped statistics segment.
+type Segment struct {
+	data []byte
+}
+
+// Create creates an empty statistics segment at path, replacing any
+// existing one.
+func Create(path string) (*Segment, error) {
+	f, err := os.OpenFile(path, os.O_RDWR|os.O_CREATE|os.O_TRUNC, 0600)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+	if err := f.Truncate(int64(unsafe.Sizeof(Snapshot{}))); err != nil {
+		return nil, err
+	}
+
+	s, err := mmap(f, syscall.PROT_READ|syscall.PROT_WRITE)
+	if err != nil {
+		return nil, err
+	}
+	atomic.StoreUint64(&s.shared().Magic, magic)
+	return s, nil
+}
+
+// Open maps the existing statistics segment at path for reading.
+func Open(path string) (*Segment, error) {
+	f, err := os.Open(path)
+	if err != nil {
+		return nil, err
+	}
+	defer f.Close()
+
+	s, err := mmap(f, syscall.PROT_READ)
+	if err != nil {
+		return nil, err
+	}
+	if atomic.LoadUint64(&s.shared().Magic) != magic {
+		s.Close()
+		return nil, fmt.Errorf("%s is not a statistics segment", path)
+	}
+	return s, nil
+}
+
+func mmap(f *os.File, prot int) (*Segment, error) {
+	size := int(unsafe.Sizeof(Snapshot{}))
+	if info, err := f.Stat(); err != nil {
+		return nil, err
+	} else if info.Size() < int64(size) {
+		return nil, fmt.Errorf("%s is too small for a statistics segment", f.Name())
+	}
+	data, err := syscall.Mmap(int(f.Fd()), 0, size, prot, syscall.MAP_SHARED)
+	if err != nil {
+		return nil, err
+	}
+	return &Segment{data: data}, nil
+}
+
+func (s *Segment) shared() *Snapshot {
+	return (*Snapshot)(unsafe.Pointer(&s.data[0]))
+}
+
+// Snapshot reads the current counters. The intercepted processes keep
+// updating them, so the counters are not consistent with each other.
+func (s *Segment) Snapshot() Snapshot {
+	shared := s.shared()
+	load := func(values []uint64, from []uint64) {
+		for i := range from {
+			values[i] = atomic.LoadUint64(&from[i])
+		}
+	}
+
+	var snapshot Snapshot
+	snapshot.Magic = atomic.LoadUint64(&shared.Magic)
+	snapshot.HookedExecs = atomic.LoadUint64(&shared.HookedExecs)
+	snapshot.ReplacedExecs = atomic.LoadUint64(&shared.ReplacedExecs)
+	snapshot.ReportFailures = atomic.LoadUint64(&shared.ReportFailures)
+	snapshot.ReportDeadlinesExceeded = atomic.LoadUint64(&shared.ReportDeadlinesExceeded)
+	load(snapshot.RuleMatches[:], shared.RuleMatches[:])
+	for i := range shared.Stages {
+		snapshot.Stages[i].Count = atomic.LoadUint64(&shared.Stages[i].Count)
+		snapshot.Stages[i].TotalNs = atomic.LoadUint64(&shared.Stages[i].TotalNs)
+		load(snapshot.Stages[i].Buckets[:], shared.Stages[i].Buckets[:])
+	}
+	return snapshot
+}
+
+// Close unmaps the segment.
+func (s *Segment) Close() error {
+	return syscall.Munmap(s.data)
+}
+
+// Quantile returns an upper bound of the q-quantile of the latencies.
+func (h *Histogram) Quantile(q float64) time.Duration {
+	if h.Count == 0 {
+		return 0
+	}
+	rank := uint64(q * float64(h.Count))
+	var seen uint64
+	for i, n := range h.Buckets {
+		seen += n
+		if n > 0 && seen > rank {
+			return time.Duration(uint64(1)<<uint(i)) * time.Microsecond
+		}
+	}
+	return time.Duration(uint64(1)<<uint(latencyBuckets-1)) * time.Microsecond
+}
+
+// Mean returns the mean latency.
+func (h *Histogram) Mean() time.Duration {
+	if h.Count == 0 {
+		return 0
+	}
+	return time.Duration(h.TotalNs / h.Count)
+}
+
+// Print writes a human readable report of the snapshot to w. ruleNames name
+// the matching rules by their index.
+func (s *Snapshot) Print(w io.Writer, ruleNames []string) error {
+	tw := tabwriter.NewWriter(w, 0, 8, 2, ' ', 0)
+	fmt.Fprintf(tw, "hooked execs:\t%d\n", s.HookedExecs)
+	fmt.Fprintf(tw, "replaced execs:\t%d\n", s.ReplacedExecs)
+	for i, n := range s.RuleMatches {
+		if n == 0 {
+			continue
+		}
+		name := fmt.Sprintf("rule %d", i)
+		if i < len(ruleNames) {
+			name = ruleNames[i]
+		}
+		fmt.Fprintf(tw, "  %s:\t%d\n", name, n)
+	}
+	fmt.Fprintf(tw, "failed reports:\t%d\n", s.ReportFailures)
+	fmt.Fprintf(tw, "  deadline exceeded:\t%d\n", s.ReportDeadlinesExceeded)
+	fmt.Fprintln(tw)
+
+	fmt.Fprintln(tw, "stage\tcount\tmean\tp50 <=\tp99 <=\ttotal")
+	for i, h := range s.Stages {
+		fmt.Fprintf(tw, "%s\t%d\t%v\t%v\t%v\t%v\n", StageNames[i], h.Count,
+			h.Mean(), h.Quantile(0.5), h.Quantile(0.99), time.Duration(h.TotalNs))
+	}
+	return tw.Flush()
+}
@@ -0,0 +1,73 @@
+package stats
+
+import (
+	"bytes"
+	"io/ioutil"
+	"os"
+	"path/filepath"
+	"strings"
+	"testing"
+	"time"
+)
+
+func TestSegmentIsSharedWithReaders(t *testing.T) {
+	dir, err := ioutil.TempDir("", "stats")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.RemoveAll(dir)
+	path := filepath.Join(dir, "stats")
+
+	writer, err := Create(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer writer.Close()
+	reader, err := Open(path)
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer reader.Close()
+
+	// what the preload interceptor does on a replaced exec
+	shared := writer.shared()
+	shared.HookedExecs = 3
+	shared.ReplacedExecs = 2
+	shared.RuleMatches[1] = 2
+	shared.Stages[0].Count = 2
+	shared.Stages[0].TotalNs = 6000
+	shared.Stages[0].Buckets[2] = 2
+
+	snapshot := reader.Snapshot()
+	if snapshot.HookedExecs != 3 || snapshot.RuleMatches[1] != 2 {
+		t.Errorf("got %+v", snapshot)
+	}
+	if mean := snapshot.Stages[0].Mean(); mean != 3*time.Microsecond {
+		t.Errorf("got mean %v, want 3µs", mean)
+	}
+	if p99 := snapshot.Stages[0].Quantile(0.99); p99 != 4*time.Microsecond {
+		t.Errorf("got p99 %v, want 4µs", p99)
+	}
+
+	var out bytes.Buffer
+	if err := snapshot.Print(&out, []string{"cc", "cxx"}); err != nil {
+		t.Fatal(err)
+	}
+	if !strings.Contains(out.String(), "cxx:") {
+		t.Errorf("rule name missing in\n%s", out.String())
+	}
+}
+
+func TestOpenRejectsOtherFiles(t *testing.T) {
+	f, err := ioutil.TempFile("", "stats")
+	if err != nil {
+		t.Fatal(err)
+	}
+	defer os.Remove(f.Name())
+	f.Write(make([]byte, 4096))
+	f.Close()
+
+	if _, err := Open(f.Name()); err == nil {
+		t.Error("opened a file without magic")
+	}
+}
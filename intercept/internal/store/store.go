@@ -0,0 +1,271 @@
+// Package store keeps the commands intercepted during a build session with
+// interned strings and argument lists.
+package store
+
+import (
+	"encoding/binary"
+	"sort"
+	"sync"
+
+	pb "gitlab.com/code-intelligence/core/build_system/proto"
+)
+
+// Strings interns strings, so that every distinct string is kept only once
+// and can be referenced by its id.
+type Strings struct {
+	ids    map[string]uint32
+	values []string
+}
+
+// Intern returns the id of value, adding it to the table if needed.
+func (s *Strings) Intern(value string) uint32 {
+	if id, found := s.ids[value]; found {
+		return id
+	}
+	if s.ids == nil {
+		s.ids = make(map[string]uint32)
+	}
+	id := uint32(len(s.values))
+	s.ids[value] = id
+	s.values = append(s.values, value)
+	return id
+}
+
+// Value returns the string with the given id.
+func (s *Strings) Value(id uint32) string {
+	return s.values[id]
+}
+
+// Values returns all interned strings, indexed by their ids.
+func (s *Strings) Values() []string {
+	return s.values
+}
+
+// Vectors interns lists of string ids.
+type Vectors struct {
+	ids    map[string]uint32
+	values [][]uint32
+}
+
+// Intern returns the id of vector, adding it to the table if needed.
+func (v *Vectors) Intern(vector []uint32) uint32 {
+	key := make([]byte, 4*len(vector))
+	for i, id := range vector {
+		binary.LittleEndian.PutUint32(key[4*i:], id)
+	}
+	if id, found := v.ids[string(key)]; found {
+		return id
+	}
+	if v.ids == nil {
+		v.ids = make(map[string]uint32)
+	}
+	id := uint32(len(v.values))
+	v.ids[string(key)] = id
+	v.values = append(v.values, vector)
+	return id
+}
+
+// Value returns the vector with the given id.
+func (v *Vectors) Value(id uint32) []uint32 {
+	return v.values[id]
+}
+
+// Values returns all interned vectors, indexed by their ids.
+func (v *Vectors) Values() [][]uint32 {
+	return v.values
+}
+
+// Command is an intercepted command whose fields are string ids and whose
+// argument lists are vector ids.
+type Command struct {
+	OriginalCommand   uint32
+	OriginalArguments uint32
+	ReplacedCommand   uint32
+	ReplacedArguments uint32
+	Directory         uint32
+	ID                uint32
+}
+
+// Store collects intercepted commands. It is safe for concurrent use.
+type Store struct {
+	mu       sync.Mutex
+	settings *pb.InterceptSettings
+	strings  Strings
+	vectors  Vectors
+	commands []Command
+
+	// files read by the commands, by command id; the reports of the
+	// processes of one command may overlap.
+	dependencies map[uint32][]uint32
+	reports      map[uint32]*reports
+}
+
+// reports counts the FileDependencies reports of a command. Its files are
+// known completely once a root report arrived and the reports received are
+// those accounted for, see intercept.proto.
+type reports struct {
+	received   map[string]struct{}
+	expected   int
+	roots      int
+	incomplete bool
+}
+
+func (r *reports) complete() bool {
+	return r != nil && !r.incomplete && r.roots > 0 && len(r.received) == r.expected
+}
+
+// New creates a Store that decodes argument deltas against settings, which
+// must be the settings the reporting processes used.
+func New(settings *pb.InterceptSettings) *Store {
+	return &Store{
+		settings:     settings,
+		dependencies: make(map[uint32][]uint32),
+		reports:      make(map[uint32]*reports),
+	}
+}
+
+// Add interns cmd and appends it to the store. It returns the index of the
+// stored command.
+func (s *Store) Add(cmd *pb.InterceptedCommand) int {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	original := s.internAll(cmd.OriginalArguments)
+	var replaced []uint32
+	if cmd.ReplacedDelta != nil {
+		replaced = s.decodeDelta(original, cmd.ReplacedDelta)
+	} else {
+		replaced = s.internAll(cmd.ReplacedArguments)
+	}
+
+	s.commands = append(s.commands, Command{
+		OriginalCommand:   s.strings.Intern(cmd.OriginalCommand),
+		OriginalArguments: s.vectors.Intern(original),
+		ReplacedCommand:   s.strings.Intern(cmd.ReplacedCommand),
+		ReplacedArguments: s.vectors.Intern(replaced),
+		Directory:         s.strings.Intern(cmd.Directory),
+		ID:                s.strings.Intern(cmd.Id),
+	})
+	return len(s.commands) - 1
+}
+
+// AddFileDependencies records files read by a process of a replaced command.
+// Reports may arrive before the command itself, and a retried report may
+// arrive twice.
+func (s *Store) AddFileDependencies(deps *pb.FileDependencies) {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	id := s.strings.Intern(deps.CommandId)
+	r := s.reports[id]
+	if r == nil {
+		r = &reports{received: make(map[string]struct{})}
+		s.reports[id] = r
+	}
+	if _, found := r.received[deps.ReportId]; found {
+		return
+	}
+	r.received[deps.ReportId] = struct{}{}
+	r.expected += int(deps.FollowingReports)
+	if deps.Root {
+		r.roots++
+		r.expected++
+	}
+	r.incomplete = r.incomplete || deps.Incomplete
+
+	s.dependencies[id] = append(s.dependencies[id], s.internAll(deps.Files)...)
+}
+
+// Len returns the number of stored commands.
+func (s *Store) Len() int {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+	return len(s.commands)
+}
+
+// Command returns the i-th stored command with its strings restored.
+func (s *Store) Command(i int) *pb.InterceptedCommand {
+	s.mu.Lock()
+	defer s.mu.Unlock()
+
+	c := s.commands[i]
+	return &pb.InterceptedCommand{
+		OriginalCommand:   s.strings.Value(c.OriginalCommand),
+		OriginalArguments: s.values(c.OriginalArguments),
+		ReplacedCommand:   s.strings.Value(c.ReplacedCommand),
+		ReplacedArguments: s.values(c.ReplacedArguments),
+		Directory:         s.strings.Value(c.Directory),
+		Id:                s.strings.Value(c.ID),
+		FileDependencies:  s.fileDependencies(c.ID),
+	}
+}
+
+// Commands returns all stored commands with their strings restored.
+func (s *Store) Commands() []*pb.InterceptedCommand {
+	cmds := make([]*pb.InterceptedCommand, s.Len())
+	for i := range cmds {
+		cmds[i] = s.Command(i)
+	}
+	return cmds
+}
+
+// fileDependencies returns the sorted files read by the command with the
+// given id, or nothing if they are not known completely.
+func (s *Store) fileDependencies(id uint32) []string {
+	if !s.reports[id].complete() || len(s.dependencies[id]) == 0 {
+		return nil
+	}
+	unique := make(map[string]struct{})
+	for _, file := range s.dependencies[id] {
+		unique[s.strings.Value(file)] = struct{}{}
+	}
+	files := make([]string, 0, len(unique))
+	for file := range unique {
+		files = append(files, file)
+	}
+	sort.Strings(files)
+	return files
+}
+
+func (s *Store) internAll(values []string) []uint32 {
+	ids := make([]uint32, len(values))
+	for i, v := range values {
+		ids[i] = s.strings.Intern(v)
+	}
+	return ids
+}
+
+func (s *Store) values(vector uint32) []string {
+	ids := s.vectors.Value(vector)
+	values := make([]string, len(ids))
+	for i, id := range ids {
+		values[i] = s.strings.Value(id)
+	}
+	return values
+}
+
+// decodeDelta mirrors DecodeArgumentDelta of the replacer library.
+func (s *Store) decodeDelta(original []uint32, delta *pb.ArgumentDelta) []uint32 {
+	replaced := make([]uint32, 0, len(original)+len(delta.AppendedArguments))
+	removed := delta.RemovedIndices
+	for i, id := range original {
+		if len(removed) > 0 && removed[0] == uint32(i) {
+			removed = removed[1:]
+			continue
+		}
+		replaced = append(replaced, id)
+	}
+
+	if delta.FirstArgument != "" && len(replaced) > 0 {
+		replaced[0] = s.strings.Intern(delta.FirstArgument)
+	}
+
+	replaced = append(replaced, s.internAll(delta.AppendedArguments)...)
+
+	rule := int(delta.SharedRule) - 1
+	if s.settings != nil && rule >= 0 && rule < len(s.settings.MatchingRules) {
+		shared := s.settings.MatchingRules[rule].AddArguments
+		replaced = append(replaced, s.internAll(shared)...)
+	}
+	return replaced
+}
@@ -0,0 +1,117 @@
+package store
+
+import (
+	"reflect"
+	"testing"
+
+	pb "gitlab.com/code-intelligence/core/build_system/proto"
+)
+
+func TestStringsAreInternedOnce(t *testing.T) {
+	var s Strings
+	a, b := s.Intern("-O2"), s.Intern("-g")
+	if s.Intern("-O2") != a || a == b {
+		t.Errorf("got ids %d, %d for distinct strings", a, b)
+	}
+	if len(s.Values()) != 2 {
+		t.Errorf("got %d strings, want 2", len(s.Values()))
+	}
+}
+
+func TestAddDecodesArgumentDelta(t *testing.T) {
+	settings := &pb.InterceptSettings{
+		MatchingRules: []*pb.MatchingRule{{AddArguments: []string{"-g", "-O0"}}},
+	}
+	s := New(settings)
+	i := s.Add(&pb.InterceptedCommand{
+		OriginalCommand:   "/usr/bin/gcc",
+		OriginalArguments: []string{"gcc", "-O2", "hello.c", "-o", "hello.o"},
+		ReplacedCommand:   "clang",
+		ReplacedDelta: &pb.ArgumentDelta{
+			FirstArgument:     "clang",
+			RemovedIndices:    []uint32{1},
+			AppendedArguments: []string{"-DFUZZ"},
+			SharedRule:        1,
+		},
+		Directory: "/src",
+	})
+
+	expected := []string{"clang", "hello.c", "-o", "hello.o", "-DFUZZ", "-g", "-O0"}
+	if got := s.Command(i).ReplacedArguments; !reflect.DeepEqual(got, expected) {
+		t.Errorf("\ngot  %+v,\nwant %+v", got, expected)
+	}
+}
+
+func TestIdenticalArgumentsShareVector(t *testing.T) {
+	s := New(nil)
+	cmd := &pb.InterceptedCommand{
+		OriginalArguments: []string{"cc", "conftest.c"},
+		ReplacedArguments: []string{"cc", "conftest.c"},
+	}
+	s.Add(cmd)
+	s.Add(cmd)
+	if s.commands[0].OriginalArguments != s.commands[1].ReplacedArguments {
+		t.Errorf("identical argument lists were stored twice")
+	}
+}
+
+func TestFileDependenciesAreMerged(t *testing.T) {
+	s := New(nil)
+	s.AddFileDependencies(&pb.FileDependencies{
+		CommandId: "1-1", Files: []string{"/src/hello.c", "/usr/include/stdio.h"},
+		Root: true, FollowingReports: 1, ReportId: "10-0",
+	})
+	i := s.Add(&pb.InterceptedCommand{Id: "1-1"})
+	s.AddFileDependencies(&pb.FileDependencies{
+		CommandId: "1-1", Files: []string{"/usr/include/stdio.h", "/src/hello.h"},
+		ReportId: "11-0",
+	})
+
+	expected := []string{"/src/hello.c", "/src/hello.h", "/usr/include/stdio.h"}
+	if got := s.Command(i).FileDependencies; !reflect.DeepEqual(got, expected) {
+		t.Errorf("\ngot  %+v,\nwant %+v", got, expected)
+	}
+
+	s.AddFileDependencies(&pb.FileDependencies{
+		CommandId: "1-1", Root: true, Incomplete: true, ReportId: "12-0",
+	})
+	if got := s.Command(i).FileDependencies; got != nil {
+		t.Errorf("got %+v for incomplete dependencies", got)
+	}
+}
+
+func TestFileDependenciesNeedAllReports(t *testing.T) {
+	s := New(nil)
+	i := s.Add(&pb.InterceptedCommand{Id: "1-1"})
+	follower := &pb.FileDependencies{
+		CommandId: "1-1", Files: []string{"/src/hello.h"}, ReportId: "11-0",
+	}
+	s.AddFileDependencies(follower)
+	if got := s.Command(i).FileDependencies; got != nil {
+		t.Errorf("got %+v without the root report", got)
+	}
+
+	// the root process spawned two processes and exec'd once
+	s.AddFileDependencies(&pb.FileDependencies{
+		CommandId: "1-1", Files: []string{"/src/hello.c"},
+		Root: true, FollowingReports: 3, ReportId: "10-0",
+	})
+	s.AddFileDependencies(&pb.FileDependencies{CommandId: "1-1", ReportId: "10-1"})
+	// a retried report is counted once
+	s.AddFileDependencies(follower)
+	if got := s.Command(i).FileDependencies; got != nil {
+		t.Errorf("got %+v with a report missing", got)
+	}
+
+	s.AddFileDependencies(&pb.FileDependencies{CommandId: "1-1", ReportId: "12-0"})
+	expected := []string{"/src/hello.c", "/src/hello.h"}
+	if got := s.Command(i).FileDependencies; !reflect.DeepEqual(got, expected) {
+		t.Errorf("\ngot  %+v,\nwant %+v", got, expected)
+	}
+
+	// a process nobody accounted for reported
+	s.AddFileDependencies(&pb.FileDependencies{CommandId: "1-1", ReportId: "13-0"})
+	if got := s.Command(i).FileDependencies; got != nil {
+		t.Errorf("got %+v with an unexpected report", got)
+	}
+}
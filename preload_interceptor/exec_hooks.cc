@@ -4,12 +4,18 @@
 #include <fcntl.h>
 #include <google/protobuf/text_format.h>
 #include <unistd.h>
+#include <chrono>
 #include <cstdarg>
 #include <iostream>
 #include <vector>
 #include "absl/types/optional.h"
+#include "build_system/replacer/io.h"
+#include "build_system/replacer/probe_cache.h"
 #include "build_system/replacer/replacer.h"
+#include "file_tracker.h"
+#include "hook_stats.h"
 #include "intercept_settings.h"
+#include "remote_executor.h"
 #include "build_system/replacer/path.h"
 
 namespace {
@@ -22,6 +28,12 @@ void unhook(char *const **envp) {
   envp = const_cast<char *const **>(&environ);
 }
 
+/// creates an id for a command replaced by this process
+std::string new_command_id() {
+  auto now = std::chrono::steady_clock::now().time_since_epoch().count();
+  return std::to_string(getpid()) + "-" + std::to_string(now);
+}
+
 /// converts a va_list of char* to a vector
 std::vector<char *> list_to_vector(va_list &args, const char *first_arg) {
   std::vector<char *> result;
@@ -47,9 +59,20 @@ std::vector<char *> to_argv(const CompilationCommand &cc) {
   return arguments;
 }
 
-/// replaces cmd according to the configuration if possible
-absl::optional<CompilationCommand> replace_compilation_command(
-    CompilationCommand cmd) {
+/// the environment a command is exec'd with
+char *const *environment() { return environ; }
+
+char *const *environment(char *const envp[]) { return envp; }
+
+/// ends this process as if it had run the probe answered by answer
+[[noreturn]] void replay(const ProbeAnswer &answer) {
+  write_all(STDOUT_FILENO, answer.standard_output());
+  write_all(STDERR_FILENO, answer.standard_error());
+  _exit(answer.exit_status());
+}
+
+/// reads the settings the driver passed through the environment
+absl::optional<InterceptSettings> read_settings() {
   InterceptSettings settings;
   std::string settings_env{std::getenv("INTERCEPT_SETTINGS")};
   if (!google::protobuf::TextFormat::ParseFromString(settings_env, &settings)) {
@@ -58,21 +81,24 @@ absl::optional<CompilationCommand> replace_compilation_command(
               << std::getenv("INTERCEPT_SETTINGS") << "\n";
     return {};
   }
-
-  Replacer replacer(settings);
-  return replacer.Replace(std::move(cmd));
+  return settings;
 }
 
 /// reports the original and replaced compilation commands to the grpc server
 /// if possible
-void report_replacement(const CompilationCommand &original,
-                        const CompilationCommand &replaced) {
+grpc::Status report_replacement(const CompilationCommand &original,
+                                const CompilationCommand &replaced,
+                                const InterceptSettings &settings,
+                                int rule_index,
+                                const std::string &command_id) {
   auto reportUrl = std::getenv("REPORT_URL");
   if (reportUrl != nullptr) {
     InterceptorClient client(
         grpc::CreateChannel(reportUrl, grpc::InsecureChannelCredentials()));
-    client.ReportInterceptedCommand(original, replaced);
+    return client.ReportInterceptedCommand(original, replaced, settings,
+                                           rule_index, command_id);
   }
+  return grpc::Status::OK;
 }
 
 template <typename... Args>
@@ -80,21 +106,70 @@ int intercept(const char *fn_name, const char *path, char *const argv[],
               Args... envp) {
   using exec_type = int (*)(const char *, char *const *, Args...);
   auto original_exec = reinterpret_cast<exec_type>(dlsym(RTLD_NEXT, fn_name));
+  record_hooked_exec();
 
-  CompilationCommand command(path, argv);
+  // Commands below a tracked replacement are part of it and stay untouched.
+  if (tracking_file_accesses()) {
+    flush_file_accesses(/*before_exec=*/true);
+    return original_exec(path, argv, envp...);
+  }
 
-  auto replaced_command = replace_compilation_command(command);
-  if (!replaced_command) {
+  absl::optional<InterceptSettings> settings;
+  absl::optional<CompilationCommand> command;
+  {
+    StageTimer timer(HookStage::kParse);
+    command.emplace(path, argv);
+    settings = read_settings();
+  }
+  if (!settings) {
     return original_exec(path, argv, envp...);
   }
 
-  report_replacement(command, *replaced_command);
-  unhook(&envp...);
-  auto exec_arguments = to_argv(*replaced_command);
+  Replacer replacer(*settings);
+  absl::optional<int> rule_index;
+  {
+    StageTimer timer(HookStage::kMatch);
+    rule_index = replacer.FindMatchingRule(command->command);
+  }
+  if (!rule_index) {
+    return original_exec(path, argv, envp...);
+  }
+  record_rule_match(*rule_index);
+  auto replaced_command = replacer.ApplyRule(*command, *rule_index);
+
+  // Probes are neither reported nor tracked, they read and write no files.
+  if (!settings->probe_cache_dir().empty()) {
+    UntrackedAccesses untracked;
+    auto answer = ProbeCache(settings->probe_cache_dir())
+                      .Answer(replaced_command, environment(envp...));
+    if (answer) replay(*answer);
+  }
 
-  replaced_command->command = get_absolute_command_path(replaced_command->command);
+  auto command_id = new_command_id();
+  {
+    StageTimer timer(HookStage::kReport);
+    record_report_status(report_replacement(
+        *command, replaced_command, *settings, *rule_index, command_id));
+  }
+  if (settings->track_file_dependencies()) {
+    track_file_accesses(command_id, &envp...);
+  } else {
+    unhook(&envp...);
+  }
+  const auto &executor = settings->matching_rules(*rule_index).remote_executor();
+  if (!executor.empty() && ExecuteRemotely(replaced_command, executor)) {
+    _exit(0);
+  }
+  replacer.UsePrecompiledHeader(&replaced_command);
+  auto exec_arguments = to_argv(replaced_command);
+
+  {
+    StageTimer timer(HookStage::kResolve);
+    replaced_command.command =
+        get_absolute_command_path(replaced_command.command);
+  }
 
-  return original_exec(replaced_command->command.data(), exec_arguments.data(),
+  return original_exec(replaced_command.command.data(), exec_arguments.data(),
                        envp...);
 }
 
@@ -0,0 +1,430 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+// The fortified inline wrappers of glibc would clash with the hooks below.
+#undef _FORTIFY_SOURCE
+
+#include "file_tracker.h"
+
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <spawn.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <atomic>
+#include <chrono>
+#include <cstdarg>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <set>
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "build_system/replacer/path.h"
+#include "hook_stats.h"
+#include "intercept_settings.h"
+
+namespace {
+
+constexpr size_t kBufferSize = 8 << 20;
+
+/// Paths of the files read by this process, each terminated by '\0'. Threads
+/// reserve their slot with a single atomic add, so recording never blocks.
+char buffer[kBufferSize];
+std::atomic<size_t> buffer_used{0};
+std::atomic<bool> recording{false};
+const char *command_id = nullptr;
+
+/// Whether this process was started by the interceptor for the command.
+bool root = false;
+/// Reports that follow from the next report of this process image.
+std::atomic<uint32_t> following_reports{0};
+/// The process of this image. A vfork'd child shares the memory of its
+/// parent, but has a pid of its own.
+pid_t image_pid = 0;
+/// Identifies the image in its report ids. It is no std::string, which might
+/// be constructed only after start_recording ran.
+char report_prefix[64];
+std::atomic<uint32_t> report_count{0};
+
+thread_local int untracked_accesses = 0;
+
+template <typename Function>
+Function next_function(const char *name) {
+  return reinterpret_cast<Function>(dlsym(RTLD_NEXT, name));
+}
+
+bool is_ignored(absl::string_view path) {
+  return path.empty() || absl::StartsWith(path, "/proc/") ||
+         absl::StartsWith(path, "/dev/") || absl::StartsWith(path, "/sys/");
+}
+
+/// Records path. Relative paths are resolved against the working directory
+/// at flush time, as compilers do not change it.
+void record(const char *path) {
+  if (!recording.load(std::memory_order_relaxed) || path == nullptr) return;
+  if (untracked_accesses > 0 || is_ignored(path)) return;
+
+  auto size = strlen(path) + 1;
+  auto offset = buffer_used.fetch_add(size, std::memory_order_relaxed);
+  if (offset + size > kBufferSize) return;
+  memcpy(buffer + offset, path, size);
+}
+
+void record_at(int dirfd, const char *path) {
+  if (path == nullptr || dirfd == AT_FDCWD || path[0] == '/') {
+    return record(path);
+  }
+  if (!recording.load(std::memory_order_relaxed)) return;
+  if (untracked_accesses > 0 || path[0] == '\0') return;
+
+  char directory[PATH_MAX];
+  auto fd_link = "/proc/self/fd/" + std::to_string(dirfd);
+  auto size = readlink(fd_link.data(), directory, sizeof(directory) - 1);
+  if (size < 0) return;
+  directory[size] = '\0';
+  record((std::string(directory) + "/" + path).data());
+}
+
+bool is_read(int flags) {
+  return (flags & O_ACCMODE) == O_RDONLY && (flags & O_DIRECTORY) == 0;
+}
+
+bool needs_mode(int flags) {
+  return (flags & O_CREAT) != 0 || (flags & O_TMPFILE) == O_TMPFILE;
+}
+
+void report(const FileDependencies &dependencies) {
+  auto reportUrl = std::getenv("REPORT_URL");
+  if (reportUrl != nullptr) {
+    InterceptorClient client(
+        grpc::CreateChannel(reportUrl, grpc::InsecureChannelCredentials()));
+    record_report_status(client.ReportFileDependencies(dependencies));
+  }
+}
+
+/// Starts a new report sequence for the current process.
+void start_image() {
+  image_pid = getpid();
+  snprintf(report_prefix, sizeof(report_prefix), "%d-%lld-", image_pid,
+           static_cast<long long>(
+               std::chrono::steady_clock::now().time_since_epoch().count()));
+  report_count = 0;
+  following_reports = 0;
+}
+
+/// A forked child reports on its own, what the parent read is its report.
+void count_fork() {
+  if (recording.load(std::memory_order_relaxed)) following_reports++;
+}
+
+void start_forked_child() {
+  if (!recording.load(std::memory_order_relaxed)) return;
+  root = false;
+  buffer_used = 0;
+  start_image();
+}
+
+__attribute__((constructor)) void start_recording() {
+  auto id = std::getenv(kTrackedCommandEnv);
+  if (id == nullptr) return;
+
+  command_id = strdup(id);
+  if (std::getenv(kTrackedRootEnv) != nullptr) {
+    root = true;
+    unsetenv(kTrackedRootEnv);
+  }
+  start_image();
+  pthread_atfork(nullptr, count_fork, start_forked_child);
+  std::atexit([] { flush_file_accesses(); });
+  recording = true;
+}
+
+}  // namespace
+
+bool tracking_file_accesses() {
+  return std::getenv(kTrackedCommandEnv) != nullptr;
+}
+
+void track_file_accesses(const std::string &command_id) {
+  setenv(kTrackedCommandEnv, command_id.data(), 1);
+  setenv(kTrackedRootEnv, "1", 1);
+}
+
+void track_file_accesses(const std::string &command_id, char *const **envp) {
+  environ = const_cast<char **>(*envp);
+  track_file_accesses(command_id);
+  *envp = environ;
+}
+
+void flush_file_accesses(bool before_exec) {
+  if (!recording.load()) return;
+  if (getpid() != image_pid) {
+    // a vfork'd child, whose parent reports what was read; the exec'd image
+    // follows from that report
+    if (before_exec) following_reports++;
+    return;
+  }
+  if (!recording.exchange(false)) return;
+
+  auto used = buffer_used.exchange(0);
+  auto cwd = current_directory();
+  std::set<std::string> files;
+  for (size_t offset = 0; offset < std::min(used, kBufferSize);) {
+    absl::string_view path(buffer + offset);
+    offset += path.size() + 1;
+    if (path.empty()) continue;
+    if (path.front() == '/') {
+      files.emplace(path);
+    } else {
+      files.emplace(cwd + "/" + std::string(path));
+    }
+  }
+  memset(buffer, 0, std::min(used, kBufferSize));
+
+  // every image reports, even without files, so that the driver can tell
+  // whether all processes of the command did
+  FileDependencies dependencies;
+  dependencies.set_command_id(command_id);
+  dependencies.set_incomplete(used > kBufferSize);
+  dependencies.set_root(root);
+  dependencies.set_following_reports(following_reports.exchange(0) +
+                                     (before_exec ? 1 : 0));
+  dependencies.set_report_id(report_prefix +
+                             std::to_string(report_count++));
+  *dependencies.mutable_files() = {files.begin(), files.end()};
+  report(dependencies);
+  // the next image of this process, or this one if exec fails, is no root
+  root = false;
+  recording = true;
+}
+
+UntrackedAccesses::UntrackedAccesses() { untracked_accesses++; }
+
+UntrackedAccesses::~UntrackedAccesses() { untracked_accesses--; }
+
+extern "C" {
+
+int __xstat(int version, const char *path, struct stat *buf);
+int __xstat64(int version, const char *path, struct stat64 *buf);
+int __fxstatat(int version, int dirfd, const char *path, struct stat *buf,
+               int flags);
+int __fxstatat64(int version, int dirfd, const char *path, struct stat64 *buf,
+                 int flags);
+
+// Hook these methods
+int open(const char *path, int flags, ...) {
+  static auto original = next_function<int (*)(const char *, int, ...)>("open");
+  mode_t mode = 0;
+  if (needs_mode(flags)) {
+    va_list args;
+    va_start(args, flags);
+    mode = va_arg(args, mode_t);
+    va_end(args);
+  }
+
+  auto fd = original(path, flags, mode);
+  if (fd >= 0 && is_read(flags)) record(path);
+  return fd;
+}
+
+int open64(const char *path, int flags, ...) {
+  static auto original =
+      next_function<int (*)(const char *, int, ...)>("open64");
+  mode_t mode = 0;
+  if (needs_mode(flags)) {
+    va_list args;
+    va_start(args, flags);
+    mode = va_arg(args, mode_t);
+    va_end(args);
+  }
+
+  auto fd = original(path, flags, mode);
+  if (fd >= 0 && is_read(flags)) record(path);
+  return fd;
+}
+
+int openat(int dirfd, const char *path, int flags, ...) {
+  static auto original =
+      next_function<int (*)(int, const char *, int, ...)>("openat");
+  mode_t mode = 0;
+  if (needs_mode(flags)) {
+    va_list args;
+    va_start(args, flags);
+    mode = va_arg(args, mode_t);
+    va_end(args);
+  }
+
+  auto fd = original(dirfd, path, flags, mode);
+  if (fd >= 0 && is_read(flags)) record_at(dirfd, path);
+  return fd;
+}
+
+int openat64(int dirfd, const char *path, int flags, ...) {
+  static auto original =
+      next_function<int (*)(int, const char *, int, ...)>("openat64");
+  mode_t mode = 0;
+  if (needs_mode(flags)) {
+    va_list args;
+    va_start(args, flags);
+    mode = va_arg(args, mode_t);
+    va_end(args);
+  }
+
+  auto fd = original(dirfd, path, flags, mode);
+  if (fd >= 0 && is_read(flags)) record_at(dirfd, path);
+  return fd;
+}
+
+int stat(const char *path, struct stat *buf) {
+  static auto original =
+      next_function<int (*)(const char *, struct stat *)>("stat");
+  auto result = original(path, buf);
+  if (result == 0 && S_ISREG(buf->st_mode)) record(path);
+  return result;
+}
+
+int stat64(const char *path, struct stat64 *buf) {
+  static auto original =
+      next_function<int (*)(const char *, struct stat64 *)>("stat64");
+  auto result = original(path, buf);
+  if (result == 0 && S_ISREG(buf->st_mode)) record(path);
+  return result;
+}
+
+// glibc before 2.33 implements stat by these
+int __xstat(int version, const char *path, struct stat *buf) {
+  static auto original =
+      next_function<int (*)(int, const char *, struct stat *)>("__xstat");
+  auto result = original(version, path, buf);
+  if (result == 0 && S_ISREG(buf->st_mode)) record(path);
+  return result;
+}
+
+int __xstat64(int version, const char *path, struct stat64 *buf) {
+  static auto original =
+      next_function<int (*)(int, const char *, struct stat64 *)>("__xstat64");
+  auto result = original(version, path, buf);
+  if (result == 0 && S_ISREG(buf->st_mode)) record(path);
+  return result;
+}
+
+int fstatat(int dirfd, const char *path, struct stat *buf, int flags) {
+  static auto original =
+      next_function<int (*)(int, const char *, struct stat *, int)>("fstatat");
+  auto result = original(dirfd, path, buf, flags);
+  if (result == 0 && S_ISREG(buf->st_mode)) record_at(dirfd, path);
+  return result;
+}
+
+int fstatat64(int dirfd, const char *path, struct stat64 *buf, int flags) {
+  static auto original =
+      next_function<int (*)(int, const char *, struct stat64 *, int)>(
+          "fstatat64");
+  auto result = original(dirfd, path, buf, flags);
+  if (result == 0 && S_ISREG(buf->st_mode)) record_at(dirfd, path);
+  return result;
+}
+
+// glibc before 2.33 implements fstatat by these
+int __fxstatat(int version, int dirfd, const char *path, struct stat *buf,
+               int flags) {
+  static auto original =
+      next_function<int (*)(int, int, const char *, struct stat *, int)>(
+          "__fxstatat");
+  auto result = original(version, dirfd, path, buf, flags);
+  if (result == 0 && S_ISREG(buf->st_mode)) record_at(dirfd, path);
+  return result;
+}
+
+int __fxstatat64(int version, int dirfd, const char *path, struct stat64 *buf,
+                 int flags) {
+  static auto original =
+      next_function<int (*)(int, int, const char *, struct stat64 *, int)>(
+          "__fxstatat64");
+  auto result = original(version, dirfd, path, buf, flags);
+  if (result == 0 && S_ISREG(buf->st_mode)) record_at(dirfd, path);
+  return result;
+}
+
+int statx(int dirfd, const char *path, int flags, unsigned int mask,
+          struct statx *buf) {
+  static auto original = next_function<int (*)(
+      int, const char *, int, unsigned int, struct statx *)>("statx");
+  auto result = original(dirfd, path, flags, mask, buf);
+  if (result == 0 && (buf->stx_mask & STATX_TYPE) != 0 &&
+      S_ISREG(buf->stx_mode)) {
+    record_at(dirfd, path);
+  }
+  return result;
+}
+
+// access does not tell files from directories, the hooked fstatat does
+int access(const char *path, int mode) {
+  static auto original =
+      next_function<int (*)(const char *, int)>("access");
+  auto result = original(path, mode);
+  struct stat buf;
+  if (result == 0 && recording.load(std::memory_order_relaxed)) {
+    fstatat(AT_FDCWD, path, &buf, 0);
+  }
+  return result;
+}
+
+int faccessat(int dirfd, const char *path, int mode, int flags) {
+  static auto original =
+      next_function<int (*)(int, const char *, int, int)>("faccessat");
+  auto result = original(dirfd, path, mode, flags);
+  struct stat buf;
+  if (result == 0 && recording.load(std::memory_order_relaxed)) {
+    fstatat(dirfd, path, &buf, flags & AT_SYMLINK_NOFOLLOW);
+  }
+  return result;
+}
+
+// The spawned processes report on their own, following from this one.
+int posix_spawn(pid_t *pid, const char *path,
+                const posix_spawn_file_actions_t *actions,
+                const posix_spawnattr_t *attributes, char *const argv[],
+                char *const envp[]) {
+  static auto original = next_function<int (*)(
+      pid_t *, const char *, const posix_spawn_file_actions_t *,
+      const posix_spawnattr_t *, char *const *, char *const *)>("posix_spawn");
+  auto result = original(pid, path, actions, attributes, argv, envp);
+  if (result == 0 && recording.load(std::memory_order_relaxed)) {
+    following_reports++;
+  }
+  return result;
+}
+
+int posix_spawnp(pid_t *pid, const char *file,
+                 const posix_spawn_file_actions_t *actions,
+                 const posix_spawnattr_t *attributes, char *const argv[],
+                 char *const envp[]) {
+  static auto original = next_function<int (*)(
+      pid_t *, const char *, const posix_spawn_file_actions_t *,
+      const posix_spawnattr_t *, char *const *, char *const *)>(
+      "posix_spawnp");
+  auto result = original(pid, file, actions, attributes, argv, envp);
+  if (result == 0 && recording.load(std::memory_order_relaxed)) {
+    following_reports++;
+  }
+  return result;
+}
+
+// Processes that end without exit still report what they read.
+void _exit(int status) {
+  static auto original = next_function<void (*)(int)>("_exit");
+  flush_file_accesses();
+  original(status);
+  __builtin_unreachable();
+}
+
+void _Exit(int status) {
+  static auto original = next_function<void (*)(int)>("_Exit");
+  flush_file_accesses();
+  original(status);
+  __builtin_unreachable();
+}
+
+}  // extern C
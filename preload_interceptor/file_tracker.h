@@ -0,0 +1,39 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <string>
+
+/// The environment variable carrying the id of the replaced command whose
+/// file accesses are recorded by this process.
+constexpr const char *kTrackedCommandEnv = "INTERCEPT_TRACKED_COMMAND";
+
+/// The environment variable marking the process that is started by the
+/// interceptor for a replaced command. That process removes it, so that its
+/// children report as followers of it.
+constexpr const char *kTrackedRootEnv = "INTERCEPT_TRACKED_ROOT";
+
+/// Returns whether this process records the files it reads, i.e. whether it
+/// was started by or below a replaced command in tracking mode.
+bool tracking_file_accesses();
+
+/// Marks the environment, so that the files read by the next exec'd command
+/// and its children are recorded for command_id.
+void track_file_accesses(const std::string &command_id);
+
+void track_file_accesses(const std::string &command_id, char *const **envp);
+
+/// Reports the files read so far and clears the record. Called at exit, and
+/// with before_exec before this process image is replaced by exec, in which
+/// case the report accounts for the report of the next image.
+void flush_file_accesses(bool before_exec = false);
+
+/// Files accessed on the calling thread while an instance exists are the
+/// interceptor's own, e.g. the statistics file, and are not recorded.
+class UntrackedAccesses {
+ public:
+  UntrackedAccesses();
+  ~UntrackedAccesses();
+  UntrackedAccesses(const UntrackedAccesses &) = delete;
+  UntrackedAccesses &operator=(const UntrackedAccesses &) = delete;
+};
@@ -0,0 +1,92 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "hook_stats.h"
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#include <cstdlib>
+#include "file_tracker.h"
+
+namespace {
+
+HookStats *map_stats() {
+  auto path = std::getenv(kStatsFileEnv);
+  if (path == nullptr) return nullptr;
+
+  UntrackedAccesses untracked;
+  auto fd = open(path, O_RDWR | O_CLOEXEC);
+  if (fd < 0) return nullptr;
+  auto mapping = mmap(nullptr, sizeof(HookStats), PROT_READ | PROT_WRITE,
+                      MAP_SHARED, fd, 0);
+  close(fd);
+  if (mapping == MAP_FAILED) return nullptr;
+
+  auto stats = static_cast<HookStats *>(mapping);
+  if (stats->magic != kStatsMagic) {
+    munmap(mapping, sizeof(HookStats));
+    return nullptr;
+  }
+  return stats;
+}
+
+/// Returns the statistics segment of the build, or nullptr if the driver did
+/// not provide one. It is mapped once per process image.
+HookStats *hook_stats() {
+  static HookStats *stats = map_stats();
+  return stats;
+}
+
+void add(std::atomic<uint64_t> *counter, uint64_t value = 1) {
+  counter->fetch_add(value, std::memory_order_relaxed);
+}
+
+int latency_bucket(uint64_t nanoseconds) {
+  auto microseconds = nanoseconds / 1000;
+  int bucket = 0;
+  while (microseconds > 0 && bucket < kLatencyBuckets - 1) {
+    microseconds >>= 1;
+    bucket++;
+  }
+  return bucket;
+}
+
+}  // namespace
+
+void record_hooked_exec() {
+  auto stats = hook_stats();
+  if (stats) add(&stats->hooked_execs);
+}
+
+void record_rule_match(int rule_index) {
+  auto stats = hook_stats();
+  if (!stats) return;
+
+  add(&stats->replaced_execs);
+  if (rule_index >= 0 && rule_index < kMaxStatsRules) {
+    add(&stats->rule_matches[rule_index]);
+  }
+}
+
+void record_report_status(const grpc::Status &status) {
+  auto stats = hook_stats();
+  if (!stats || status.ok()) return;
+
+  add(&stats->report_failures);
+  if (status.error_code() == grpc::StatusCode::DEADLINE_EXCEEDED) {
+    add(&stats->report_deadlines_exceeded);
+  }
+}
+
+StageTimer::~StageTimer() {
+  auto stats = hook_stats();
+  if (!stats) return;
+
+  uint64_t elapsed = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::steady_clock::now() - start_)
+                         .count();
+  auto &histogram = stats->stages[static_cast<int>(stage_)];
+  add(&histogram.count);
+  add(&histogram.total_ns, elapsed);
+  add(&histogram.buckets[latency_bucket(elapsed)]);
+}
@@ -0,0 +1,70 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <grpc++/grpc++.h>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+
+/// The environment variable naming the statistics file of the build.
+constexpr const char *kStatsFileEnv = "INTERCEPT_STATS";
+
+constexpr uint64_t kStatsMagic = 0x3153544154534349;  // "ICSTATS1"
+constexpr int kMaxStatsRules = 16;
+constexpr int kLatencyBuckets = 24;
+
+/// The stages of intercepting an exec.
+enum class HookStage {
+  kParse,    // reading the settings and the command
+  kMatch,    // matching the command against the rules
+  kResolve,  // resolving the replaced command in PATH
+  kReport,   // reporting the replacement to the driver
+  kCount,
+};
+
+/// Latencies of one stage. Bucket i counts latencies below 2^i microseconds
+/// that did not fit into bucket i - 1; the last bucket counts the rest.
+struct LatencyHistogram {
+  std::atomic<uint64_t> count;
+  std::atomic<uint64_t> total_ns;
+  std::atomic<uint64_t> buckets[kLatencyBuckets];
+};
+
+/// The statistics segment shared by all intercepted processes of a build. It
+/// is created by the driver, which reads it with the mirrored layout in
+/// intercept/internal/stats; both have to be changed together.
+struct HookStats {
+  uint64_t magic;
+  std::atomic<uint64_t> hooked_execs;
+  std::atomic<uint64_t> replaced_execs;
+  std::atomic<uint64_t> report_failures;
+  std::atomic<uint64_t> report_deadlines_exceeded;
+  std::atomic<uint64_t> rule_matches[kMaxStatsRules];
+  LatencyHistogram stages[static_cast<int>(HookStage::kCount)];
+};
+
+static_assert(sizeof(std::atomic<uint64_t>) == sizeof(uint64_t),
+              "HookStats has to be shareable with the driver");
+
+/// Counts an exec that went through the hooks.
+void record_hooked_exec();
+
+/// Counts an exec replaced according to the rule at rule_index.
+void record_rule_match(int rule_index);
+
+/// Counts failed reports to the driver.
+void record_report_status(const grpc::Status &status);
+
+/// Adds the time from its construction to its destruction to the latencies
+/// of a stage.
+class StageTimer {
+ public:
+  explicit StageTimer(HookStage stage)
+      : stage_(stage), start_(std::chrono::steady_clock::now()) {}
+  ~StageTimer();
+
+ private:
+  HookStage stage_;
+  std::chrono::steady_clock::time_point start_;
+};
@@ -1,8 +1,20 @@
 // Copyright (c) 2018 University of Bonn.
 
 #include "intercept_settings.h"
+#include "build_system/replacer/argument_delta.h"
 #include "build_system/replacer/path.h"
 #include <unistd.h>
+#include <chrono>
+
+namespace {
+
+/// A lost dependency report makes the files of its command incomplete, so it
+/// is given more time than the other calls, and is retried. The driver counts
+/// a report that arrives more than once by its report_id.
+constexpr auto kDependencyReportTimeout = std::chrono::seconds(5);
+constexpr int kDependencyReportAttempts = 3;
+
+}  // namespace
 
 InterceptorClient::InterceptorClient(std::shared_ptr<grpc::Channel> channel)
     : stub_(Interceptor::NewStub(channel)) {}
@@ -24,8 +36,12 @@ absl::optional<InterceptSettings> InterceptorClient::GetSettings() {
   return settings;
 }
 
-void InterceptorClient::ReportInterceptedCommand(
-    const CompilationCommand& orig_cc, const CompilationCommand& new_cc) {
+grpc::Status InterceptorClient::ReportInterceptedCommand(
+    const CompilationCommand& orig_cc, const CompilationCommand& new_cc,
+    const InterceptSettings& settings, int rule_index,
+    const std::string& command_id) {
+  // no deadline: a report that is dropped loses the command's entry in the
+  // compilation database, which is worth waiting for under load
   grpc::ClientContext context;
   Status response;
 
@@ -34,17 +50,41 @@ void InterceptorClient::ReportInterceptedCommand(
   cmd.set_original_command(orig_cc.command);
   cmd.set_replaced_command(new_cc.command);
   cmd.set_directory(cwd);
+  cmd.set_id(command_id);
 
   *cmd.mutable_original_arguments() = {orig_cc.arguments.begin(),
                                        orig_cc.arguments.end()};
-  *cmd.mutable_replaced_arguments() = {new_cc.arguments.begin(),
-                                       new_cc.arguments.end()};
+  *cmd.mutable_replaced_delta() =
+      EncodeArgumentDelta(orig_cc, new_cc, settings, rule_index);
 
   auto status = stub_->ReportInterceptedCommand(&context, cmd, &response);
   if (!status.ok()) {
     std::cout << "Error reporting command " << status.error_message()
               << status.error_details() << std::endl;
   }
+  return status;
+}
+
+grpc::Status InterceptorClient::ReportFileDependencies(
+    const FileDependencies& dependencies) {
+  grpc::Status status;
+  for (int attempt = 0; attempt < kDependencyReportAttempts; ++attempt) {
+    grpc::ClientContext context;
+    Status response;
+    context.set_deadline(std::chrono::system_clock::now() +
+                         kDependencyReportTimeout);
+
+    status = stub_->ReportFileDependencies(&context, dependencies, &response);
+    if (status.error_code() != grpc::StatusCode::UNAVAILABLE &&
+        status.error_code() != grpc::StatusCode::DEADLINE_EXCEEDED) {
+      break;
+    }
+  }
+  if (!status.ok()) {
+    std::cout << "Error reporting file dependencies " << status.error_message()
+              << status.error_details() << std::endl;
+  }
+  return status;
 }
 
 void InterceptorClient::SetDefaultDeadline(grpc::ClientContext* context) {
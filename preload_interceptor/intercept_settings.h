@@ -19,10 +19,22 @@ class InterceptorClient {
   ~InterceptorClient() = default;
 
   absl::optional<InterceptSettings> GetSettings();
-  void ReportInterceptedCommand(const CompilationCommand& orig_cc,
-                                const CompilationCommand& new_cc);
 
-      private : void SetDefaultDeadline(grpc::ClientContext* context);
+  /// Reports the replacement of orig_cc by new_cc through the rule at
+  /// rule_index. The replaced arguments are sent as an ArgumentDelta against
+  /// orig_cc and that rule. The call waits for the driver without a deadline.
+  grpc::Status ReportInterceptedCommand(const CompilationCommand& orig_cc,
+                                        const CompilationCommand& new_cc,
+                                        const InterceptSettings& settings,
+                                        int rule_index,
+                                        const std::string& command_id);
+
+  /// Reports the files read by a process of a replaced command. Calls that
+  /// time out or find the driver unavailable are retried.
+  grpc::Status ReportFileDependencies(const FileDependencies& dependencies);
+
+ private:
+  void SetDefaultDeadline(grpc::ClientContext* context);
 
   std::unique_ptr<Interceptor::Stub> stub_;
 };
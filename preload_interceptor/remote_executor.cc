@@ -0,0 +1,205 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "remote_executor.h"
+
+#include <openssl/sha.h>
+#include <unistd.h>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <grpc++/grpc++.h>
+#include "absl/types/optional.h"
+#include "build_system/proto/intercept.grpc.pb.h"
+#include "build_system/replacer/io.h"
+#include "build_system/replacer/path.h"
+#include "build_system/replacer/side_outputs.h"
+#include "build_system/replacer/source_files.h"
+
+namespace {
+
+constexpr auto kQueryTimeout = std::chrono::seconds(5);
+constexpr auto kUploadTimeout = std::chrono::seconds(30);
+constexpr auto kExecuteTimeout = std::chrono::minutes(10);
+constexpr int kMaxObjectSize = 256 << 20;
+
+/// A compilation of one source to one object.
+struct Compilation {
+  std::string source;
+  std::string object;
+  std::string input_suffix;
+  CompilationCommand::ArgsT::const_iterator source_argument;
+};
+
+/// The object gcc and clang write for source without -o.
+std::string default_object(const std::string &source) {
+  auto name = source.substr(source.rfind('/') + 1);
+  return name.substr(0, name.rfind('.')) + ".o";
+}
+
+absl::optional<Compilation> parse_compilation(const CompilationCommand &cc) {
+  if (cc.arguments.empty()) return {};
+  absl::optional<Compilation> compilation;
+  bool compiles = false;
+  bool output_follows = false;
+  std::string object;
+  for (auto it = std::next(cc.arguments.begin()); it != cc.arguments.end();
+       ++it) {
+    if (output_follows) {
+      object = *it;
+      output_follows = false;
+      continue;
+    }
+    if (*it == "-c") compiles = true;
+    // their outputs would stay on the executor
+    if (WritesSideOutputs(*it)) return {};
+    if (*it == "-o") output_follows = true;
+    // reading the source from stdin or from several files is not supported
+    if (*it == "-" || *it == "-x") return {};
+
+    if (!IsInputFile(*it)) continue;
+    // other inputs, e.g. assembly, are not compiled remotely
+    auto language = SourceLanguage(*it);
+    if (!language || compilation) return {};
+    compilation.emplace();
+    compilation->source = *it;
+    compilation->input_suffix = *language == "c" ? ".i" : ".ii";
+    compilation->source_argument = it;
+  }
+  if (!compiles || !compilation) return {};
+  compilation->object =
+      object.empty() ? default_object(compilation->source) : object;
+  return compilation;
+}
+
+/// Preprocesses the compilation into output. Dependency files are written as
+/// by the compilation, since they are not produced remotely.
+bool preprocess(const CompilationCommand &cc, const Compilation &compilation,
+                const std::string &output) {
+  CompilationCommand::ArgsT arguments;
+  bool writes_dependencies = false, names_target = false, names_file = false;
+  bool skip_next = false;
+  for (const auto &argument : cc.arguments) {
+    if (skip_next) {
+      skip_next = false;
+      continue;
+    }
+    if (argument == "-o") {
+      skip_next = true;
+      continue;
+    }
+    writes_dependencies |= argument == "-MD" || argument == "-MMD";
+    names_target |= argument == "-MT" || argument == "-MQ";
+    names_file |= argument == "-MF";
+    arguments.emplace_back(argument == "-c" ? "-E" : argument);
+  }
+  arguments.insert(arguments.end(), {"-o", output});
+  if (writes_dependencies && !names_target) {
+    arguments.insert(arguments.end(), {"-MT", compilation.object});
+  }
+  if (writes_dependencies && !names_file) {
+    auto object = compilation.object;
+    arguments.insert(arguments.end(),
+                     {"-MF", object.substr(0, object.rfind('.')) + ".d"});
+  }
+  // with the current environment, so files read while preprocessing are
+  // tracked like those of a local compilation
+  return run(cc.command, arguments, environ) == 0;
+}
+
+Digest digest_of(const std::string &content) {
+  unsigned char hash[SHA256_DIGEST_LENGTH];
+  SHA256(reinterpret_cast<const unsigned char *>(content.data()),
+         content.size(), hash);
+
+  static const char kHex[] = "0123456789abcdef";
+  std::string hex;
+  for (auto byte : hash) {
+    hex += kHex[byte >> 4];
+    hex += kHex[byte & 0xf];
+  }
+  Digest digest;
+  digest.set_sha256(hex);
+  digest.set_size(content.size());
+  return digest;
+}
+
+void set_timeout(grpc::ClientContext *context,
+                 std::chrono::system_clock::duration timeout) {
+  context->set_deadline(std::chrono::system_clock::now() + timeout);
+}
+
+/// Uploads content unless the executor already stores it.
+bool upload(Executor::Stub *stub, const Digest &digest,
+            const std::string &content) {
+  FindMissingBlobsRequest request;
+  *request.add_digests() = digest;
+  FindMissingBlobsResponse missing;
+  {
+    grpc::ClientContext context;
+    set_timeout(&context, kQueryTimeout);
+    if (!stub->FindMissingBlobs(&context, request, &missing).ok()) return false;
+  }
+  if (missing.missing_size() == 0) return true;
+
+  UploadBlobsRequest upload;
+  auto blob = upload.add_blobs();
+  *blob->mutable_digest() = digest;
+  blob->set_content(content);
+  Status response;
+  grpc::ClientContext context;
+  set_timeout(&context, kUploadTimeout);
+  return stub->UploadBlobs(&context, upload, &response).ok();
+}
+
+}  // namespace
+
+bool ExecuteRemotely(const CompilationCommand &cc, const std::string &address) {
+  auto compilation = parse_compilation(cc);
+  if (!compilation) return false;
+
+  char preprocessed_path[] = "/tmp/intercept-XXXXXX";
+  auto fd = mkstemp(preprocessed_path);
+  if (fd < 0) return false;
+  close(fd);
+  absl::optional<std::string> preprocessed;
+  if (preprocess(cc, *compilation, preprocessed_path)) {
+    preprocessed = read_file(preprocessed_path);
+  }
+  unlink(preprocessed_path);
+  if (!preprocessed) return false;
+
+  CompileAction action;
+  for (auto it = cc.arguments.begin(); it != cc.arguments.end(); ++it) {
+    if (it == compilation->source_argument) continue;
+    // options naming files that were read or written while preprocessing
+    if (*it == "-o" || *it == "-MF" || *it == "-MT" || *it == "-MQ" ||
+        *it == "-include" || *it == "-imacros") {
+      if (++it == cc.arguments.end()) break;
+      continue;
+    }
+    if (*it == "-MD" || *it == "-MMD" || *it == "-MP") continue;
+    action.add_arguments(*it);
+  }
+  *action.mutable_input() = digest_of(*preprocessed);
+  action.set_input_suffix(compilation->input_suffix);
+  // the size of the preprocessed source is a fair proxy for compile time
+  action.set_estimated_cost(preprocessed->size());
+  action.set_directory(current_directory());
+
+  grpc::ChannelArguments channel_arguments;
+  channel_arguments.SetMaxReceiveMessageSize(kMaxObjectSize);
+  auto stub = Executor::NewStub(grpc::CreateCustomChannel(
+      address, grpc::InsecureChannelCredentials(), channel_arguments));
+  if (!upload(stub.get(), action.input(), *preprocessed)) return false;
+
+  CompileResult result;
+  grpc::ClientContext context;
+  set_timeout(&context, kExecuteTimeout);
+  if (!stub->Execute(&context, action, &result).ok()) return false;
+  if (result.exit_code() != 0) return false;
+  if (!write_file(compilation->object, result.object())) return false;
+
+  write_all(STDOUT_FILENO, result.standard_output());
+  write_all(STDERR_FILENO, result.standard_error());
+  return true;
+}
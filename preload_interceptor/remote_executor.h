@@ -0,0 +1,21 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <string>
+#include "build_system/replacer/compilation_command.h"
+
+/// Compiles cc on the Executor service at address: the source is
+/// preprocessed locally, uploaded unless the executor already stores it and
+/// compiled remotely, and the returned object is written to the output of cc
+/// along with the compiler's stdout and stderr.
+///
+/// The working directory of the client is sent along, so debug information
+/// records it as compilation directory instead of the executor's.
+///
+/// Returns false if cc is not a single-source compilation to an object, if it
+/// writes side outputs such as split DWARF or is instrumented for coverage,
+/// or if anything on the way fails, including the remote compilation itself.
+/// The caller then compiles locally, which also reports diagnostics against
+/// the original source.
+bool ExecuteRemotely(const CompilationCommand &cc, const std::string &address);
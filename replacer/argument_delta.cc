@@ -0,0 +1,91 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/replacer/argument_delta.h"
+
+#include <algorithm>
+#include <iterator>
+
+namespace {
+
+/// Moves the add_arguments of the rule at rule_index into the shared rule
+/// reference if they end the appended arguments.
+void ExtractSharedArguments(ArgumentDelta *delta,
+                            const InterceptSettings &settings,
+                            int rule_index) {
+  if (rule_index < 0 || rule_index >= settings.matching_rules_size()) return;
+
+  auto *appended = delta->mutable_appended_arguments();
+  const auto &shared = settings.matching_rules(rule_index).add_arguments();
+  if (shared.empty() || shared.size() > appended->size()) return;
+
+  auto suffix = appended->end() - shared.size();
+  if (!std::equal(shared.begin(), shared.end(), suffix)) return;
+
+  appended->erase(suffix, appended->end());
+  delta->set_shared_rule(rule_index + 1);
+}
+
+}  // anonymous namespace
+
+ArgumentDelta EncodeArgumentDelta(const CompilationCommand &original_cc,
+                                  const CompilationCommand &replaced_cc,
+                                  const InterceptSettings &settings,
+                                  int rule_index) {
+  ArgumentDelta delta;
+  const auto &original = original_cc.arguments;
+  const auto &replaced = replaced_cc.arguments;
+  if (original.empty() || replaced.empty()) {
+    *delta.mutable_appended_arguments() = {replaced.begin(), replaced.end()};
+    for (uint32_t i = 0; i < original.size(); i++) delta.add_removed_indices(i);
+    return delta;
+  }
+
+  if (replaced.front() != original.front()) {
+    delta.set_first_argument(replaced.front());
+  }
+
+  // Keep every original argument that matches the next replaced argument;
+  // whatever is left of the replaced arguments has been appended.
+  auto replaced_it = std::next(replaced.begin());
+  auto original_it = std::next(original.begin());
+  for (uint32_t i = 1; original_it != original.end(); ++original_it, i++) {
+    if (replaced_it != replaced.end() && *replaced_it == *original_it) {
+      ++replaced_it;
+    } else {
+      delta.add_removed_indices(i);
+    }
+  }
+  *delta.mutable_appended_arguments() = {replaced_it, replaced.end()};
+
+  ExtractSharedArguments(&delta, settings, rule_index);
+  return delta;
+}
+
+CompilationCommand::ArgsT DecodeArgumentDelta(
+    const CompilationCommand &original_cc, const ArgumentDelta &delta,
+    const InterceptSettings &settings) {
+  CompilationCommand::ArgsT arguments;
+  auto removed_it = delta.removed_indices().begin();
+  uint32_t i = 0;
+  for (const auto &argument : original_cc.arguments) {
+    if (removed_it != delta.removed_indices().end() && *removed_it == i++) {
+      ++removed_it;
+      continue;
+    }
+    arguments.emplace_back(argument);
+  }
+
+  if (!delta.first_argument().empty() && !arguments.empty()) {
+    arguments.front() = delta.first_argument();
+  }
+
+  arguments.insert(arguments.end(), delta.appended_arguments().begin(),
+                   delta.appended_arguments().end());
+
+  auto rule = delta.shared_rule() - 1;
+  if (rule >= 0 && rule < settings.matching_rules_size()) {
+    const auto &shared = settings.matching_rules(rule).add_arguments();
+    arguments.insert(arguments.end(), shared.begin(), shared.end());
+  }
+  return arguments;
+}
@@ -0,0 +1,21 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include "build_system/proto/intercept.pb.h"
+#include "build_system/replacer/compilation_command.h"
+
+/// Encodes the arguments of replaced_cc relative to the arguments of
+/// original_cc. rule_index is the rule in settings that produced replaced_cc,
+/// as returned by Replacer::FindMatchingRule. Trailing arguments equal to its
+/// add_arguments are referenced by the rule's index instead of being copied.
+ArgumentDelta EncodeArgumentDelta(const CompilationCommand &original_cc,
+                                  const CompilationCommand &replaced_cc,
+                                  const InterceptSettings &settings,
+                                  int rule_index);
+
+/// Restores the replaced arguments from original_cc and an ArgumentDelta
+/// created by EncodeArgumentDelta with the same settings.
+CompilationCommand::ArgsT DecodeArgumentDelta(
+    const CompilationCommand &original_cc, const ArgumentDelta &delta,
+    const InterceptSettings &settings);
@@ -0,0 +1,84 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/replacer/io.h"
+
+#include <spawn.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include "absl/strings/match.h"
+
+absl::optional<std::string> read_file(const std::string &path) {
+  std::ifstream file(path, std::ios::binary);
+  if (!file) return {};
+  std::stringstream content;
+  content << file.rdbuf();
+  return content.str();
+}
+
+bool write_file(const std::string &path, const std::string &content) {
+  auto temporary = path + ".tmp." + std::to_string(getpid());
+  {
+    std::ofstream file(temporary, std::ios::binary | std::ios::trunc);
+    file << content;
+    if (!file.flush()) {
+      unlink(temporary.data());
+      return false;
+    }
+  }
+  if (rename(temporary.data(), path.data()) != 0) {
+    unlink(temporary.data());
+    return false;
+  }
+  return true;
+}
+
+void write_all(int fd, const std::string &content) {
+  for (size_t written = 0; written < content.size();) {
+    auto result = write(fd, content.data() + written, content.size() - written);
+    if (result <= 0) return;
+    written += result;
+  }
+}
+
+std::vector<char *> without_preload(char *const envp[]) {
+  std::vector<char *> environment;
+  for (auto env = envp; *env != nullptr; ++env) {
+    if (!absl::StartsWith(*env, "LD_PRELOAD=")) environment.emplace_back(*env);
+  }
+  environment.emplace_back(nullptr);
+  return environment;
+}
+
+absl::optional<int> run(const std::string &command,
+                        const CompilationCommand::ArgsT &arguments,
+                        char *const envp[], StandardStreams streams) {
+  std::vector<char *> argv;
+  for (const auto &argument : arguments) {
+    argv.emplace_back(const_cast<char *>(argument.data()));
+  }
+  argv.emplace_back(nullptr);
+
+  posix_spawn_file_actions_t actions;
+  posix_spawn_file_actions_init(&actions);
+  if (streams.input >= 0) {
+    posix_spawn_file_actions_adddup2(&actions, streams.input, STDIN_FILENO);
+  }
+  if (streams.output >= 0) {
+    posix_spawn_file_actions_adddup2(&actions, streams.output, STDOUT_FILENO);
+  }
+  if (streams.error >= 0) {
+    posix_spawn_file_actions_adddup2(&actions, streams.error, STDERR_FILENO);
+  }
+
+  pid_t pid;
+  int status;
+  auto spawned = posix_spawnp(&pid, command.data(), &actions, nullptr,
+                              argv.data(), envp) == 0 &&
+                 waitpid(pid, &status, 0) == pid;
+  posix_spawn_file_actions_destroy(&actions);
+  if (!spawned || !WIFEXITED(status)) return {};
+  return WEXITSTATUS(status);
+}
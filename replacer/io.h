@@ -0,0 +1,39 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "absl/types/optional.h"
+#include "build_system/replacer/compilation_command.h"
+
+/// @returns the content of the file at path, or nothing if it cannot be read.
+absl::optional<std::string> read_file(const std::string &path);
+
+/// Writes content to a temporary file next to path and renames it to path, so
+/// that concurrent readers see the old or the new content, but never a part.
+bool write_file(const std::string &path, const std::string &content);
+
+/// Writes all of content to fd, giving up at the first error.
+void write_all(int fd, const std::string &content);
+
+/// @returns envp without LD_PRELOAD, for commands that must not be
+/// intercepted, terminated by a null pointer.
+std::vector<char *> without_preload(char *const envp[]);
+
+/// File descriptors a command runs with, -1 inherits the stream.
+struct StandardStreams {
+  int input = -1;
+  int output = -1;
+  int error = -1;
+};
+
+/// Runs arguments, whose first is the name of the program, from command with
+/// the environment envp and waits for it. command is looked up in PATH unless
+/// it contains a slash.
+///
+/// @returns the exit status, or nothing if the command could not be started
+/// or was killed.
+absl::optional<int> run(const std::string &command,
+                        const CompilationCommand::ArgsT &arguments,
+                        char *const envp[], StandardStreams streams = {});
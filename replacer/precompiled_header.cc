@@ -0,0 +1,290 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/replacer/precompiled_header.h"
+
+#include <fcntl.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <fstream>
+#include <set>
+#include <google/protobuf/text_format.h>
+#include "absl/strings/ascii.h"
+#include "absl/strings/match.h"
+#include "absl/strings/strip.h"
+#include "build_system/replacer/io.h"
+#include "build_system/replacer/path.h"
+#include "build_system/replacer/source_files.h"
+
+namespace {
+
+/// Options whose argument names a per-compilation output.
+const std::set<absl::string_view> OUTPUT_OPTIONS = {"-o", "-MF", "-MT", "-MQ"};
+
+constexpr size_t kMaxIncludes = 64;
+
+std::string directory_name(const std::string &path) {
+  auto slash = path.rfind('/');
+  if (slash == std::string::npos) return ".";
+  if (slash == 0) return "/";
+  return path.substr(0, slash);
+}
+
+absl::optional<timespec> modification_time(const std::string &path) {
+  struct stat info;
+  if (stat(path.data(), &info) != 0) return {};
+  return info.st_mtim;
+}
+
+bool is_newer(const timespec &lhs, const timespec &rhs) {
+  return lhs.tv_sec > rhs.tv_sec ||
+         (lhs.tv_sec == rhs.tv_sec && lhs.tv_nsec > rhs.tv_nsec);
+}
+
+/// Returns the normalized include of a directive line, if it is one.
+absl::optional<std::string> parse_include(absl::string_view line,
+                                          const std::string &source_dir) {
+  if (!absl::ConsumePrefix(&line, "#")) return {};
+  line = absl::StripLeadingAsciiWhitespace(line);
+  if (!absl::ConsumePrefix(&line, "include")) return {};
+  line = absl::StripLeadingAsciiWhitespace(line);
+  if (line.empty()) return {};
+
+  auto close = line.front() == '<' ? '>' : '"';
+  if (line.front() != '<' && line.front() != '"') return {};
+  auto end = line.find(close, 1);
+  if (end == absl::string_view::npos) return {};
+
+  auto name = std::string(line.substr(1, end - 1));
+  if (close == '>') return "<" + name + ">";
+
+  auto local = source_dir + "/" + name;
+  char *canonical = realpath(local.data(), nullptr);
+  if (canonical == nullptr) return "\"" + name + "\"";
+  std::string result = "\"" + std::string(canonical) + "\"";
+  free(canonical);
+  return result;
+}
+
+/// A precompiled header is fresh if it is newer than all files it was built
+/// from.
+bool is_fresh(const std::string &pch) {
+  auto built = modification_time(pch);
+  if (!built) return false;
+
+  auto rule = read_file(pch + ".d");
+  if (!rule) return false;
+  auto dependencies = ParseDependencyRule(*rule);
+  if (dependencies.empty()) return false;
+  for (const auto &dependency : dependencies) {
+    auto modified = modification_time(dependency);
+    if (!modified || is_newer(*modified, *built)) return false;
+  }
+  return true;
+}
+
+bool build(const std::string &compiler, const PrecompiledHeader &header,
+           const std::string &pch) {
+  CompilationCommand::ArgsT arguments;
+  for (const auto &argument : header.arguments()) {
+    if (argument != "-c") arguments.emplace_back(argument);
+  }
+  if (arguments.empty()) return false;
+  arguments.front() = compiler;
+
+  // Both files are replaced by renames, so that the freshness check without
+  // the lock never reads a partially written dependency file.
+  auto temporary = pch + ".tmp." + std::to_string(getpid());
+  auto dependencies = temporary + ".d";
+  arguments.insert(arguments.end(),
+                   {"-x", header.language() + "-header", header.header(), "-o",
+                    temporary, "-MD", "-MF", dependencies});
+  // without the preloaded interceptor, which would intercept the build again
+  auto environment = without_preload(environ);
+  auto built = run(compiler, arguments, environment.data()) == 0 &&
+               rename(dependencies.data(), (pch + ".d").data()) == 0 &&
+               rename(temporary.data(), pch.data()) == 0;
+  unlink(dependencies.data());
+  unlink(temporary.data());
+  return built;
+}
+
+/// Builds pch unless it is fresh or failed to build from the current header.
+/// Concurrent compilations of the group wait for the first one to build it.
+bool ensure_built(const std::string &compiler, const PrecompiledHeader &header,
+                  const std::string &pch) {
+  if (is_fresh(pch)) return true;
+
+  auto failed = pch + ".failed";
+  auto failed_time = modification_time(failed);
+  auto header_time = modification_time(header.header());
+  if (!header_time) return false;
+  if (failed_time && !is_newer(*header_time, *failed_time)) return false;
+
+  auto lock_path = pch + ".lock";
+  auto lock = open(lock_path.data(), O_CREAT | O_RDWR | O_CLOEXEC, 0644);
+  if (lock < 0) return false;
+  flock(lock, LOCK_EX);
+
+  auto built = is_fresh(pch) || build(compiler, header, pch);
+  if (!built) touch(failed.data());
+
+  flock(lock, LOCK_UN);
+  close(lock);
+  return built;
+}
+
+}  // anonymous namespace
+
+std::vector<std::string> ParseDependencyRule(absl::string_view rule) {
+  auto colon = rule.find(": ");
+  if (colon == absl::string_view::npos) return {};
+
+  std::vector<std::string> dependencies;
+  std::string dependency;
+  auto end_dependency = [&] {
+    if (!dependency.empty()) dependencies.emplace_back(std::move(dependency));
+    dependency.clear();
+  };
+  for (auto i = colon + 1; i < rule.size(); ++i) {
+    auto c = rule[i];
+    auto next = i + 1 < rule.size() ? rule[i + 1] : '\0';
+    if (c == '\\' && (next == ' ' || next == '#')) {
+      dependency += next;
+      ++i;
+    } else if (c == '\\' && (next == '\n' || next == '\r')) {
+      // a continued line
+      end_dependency();
+      ++i;
+      if (next == '\r' && i + 1 < rule.size() && rule[i + 1] == '\n') ++i;
+    } else if (c == '$' && next == '$') {
+      dependency += '$';
+      ++i;
+    } else if (c == '\n') {
+      // the end of the rule, e.g. before the phony targets of -MP
+      break;
+    } else if (c == ' ' || c == '\t' || c == '\r') {
+      end_dependency();
+    } else {
+      dependency += c;
+    }
+  }
+  end_dependency();
+  return dependencies;
+}
+
+std::vector<std::string> ReadIncludePrefix(const std::string &source) {
+  std::ifstream file(source);
+  auto source_dir = directory_name(source);
+  std::vector<std::string> includes;
+  bool in_comment = false;
+
+  std::string line;
+  while (includes.size() < kMaxIncludes && std::getline(file, line)) {
+    auto text = absl::StripAsciiWhitespace(line);
+    if (in_comment) {
+      auto end = text.find("*/");
+      if (end == absl::string_view::npos) continue;
+      in_comment = false;
+      text = absl::StripAsciiWhitespace(text.substr(end + 2));
+    }
+    if (text.empty() || absl::StartsWith(text, "//")) continue;
+    if (absl::StartsWith(text, "/*")) {
+      auto end = text.find("*/", 2);
+      if (end == absl::string_view::npos) {
+        in_comment = true;
+        continue;
+      }
+      if (!absl::StripAsciiWhitespace(text.substr(end + 2)).empty()) break;
+      continue;
+    }
+
+    auto include = parse_include(text, source_dir);
+    if (!include) break;
+    includes.emplace_back(std::move(*include));
+  }
+  return includes;
+}
+
+CompilationCommand::ArgsT PchGroupArguments(
+    const CompilationCommand::ArgsT &arguments) {
+  CompilationCommand::ArgsT result;
+  bool skip_next = false;
+  for (const auto &argument : arguments) {
+    if (skip_next) {
+      skip_next = false;
+      continue;
+    }
+    if (OUTPUT_OPTIONS.count(argument) > 0) {
+      skip_next = true;
+      continue;
+    }
+    if (IsInputFile(argument)) continue;
+    result.emplace_back(argument);
+  }
+  return result;
+}
+
+absl::optional<PrecompiledHeaders> PrecompiledHeaders::Load(
+    const std::string &path) {
+  auto content = read_file(path);
+  PrecompiledHeaderPlan plan;
+  if (!content ||
+      !google::protobuf::TextFormat::ParseFromString(*content, &plan)) {
+    return {};
+  }
+  return PrecompiledHeaders(std::move(plan));
+}
+
+void PrecompiledHeaders::Use(CompilationCommand *cc,
+                             const std::string &directory) const {
+  if (std::find(cc->arguments.begin(), cc->arguments.end(), "-c") ==
+      cc->arguments.end()) {
+    return;
+  }
+
+  std::vector<std::string> sources;
+  std::copy_if(cc->arguments.begin(), cc->arguments.end(),
+               std::back_inserter(sources), IsInputFile);
+  if (sources.size() != 1) return;
+  auto language = SourceLanguage(sources.front());
+  if (!language) return;
+
+  auto header = Find(*cc, directory, sources.front(), *language);
+  if (!header) return;
+
+  auto clang = absl::StrContains(basename(cc->command), "clang");
+  auto pch = header->header() + (clang ? ".pch" : ".gch");
+  if (!ensure_built(cc->command, *header, pch)) return;
+
+  if (clang) {
+    cc->arguments.insert(cc->arguments.end(), {"-include-pch", pch});
+  } else {
+    // gcc picks up header.gch next to the header and falls back to the
+    // header itself if it is not usable.
+    cc->arguments.insert(cc->arguments.end(), {"-include", header->header()});
+  }
+}
+
+const PrecompiledHeader *PrecompiledHeaders::Find(
+    const CompilationCommand &cc, const std::string &directory,
+    const std::string &source, const std::string &language) const {
+  auto arguments = PchGroupArguments(cc.arguments);
+  for (const auto &header : plan_.headers()) {
+    if (header.directory() != directory || header.language() != language ||
+        !std::equal(arguments.begin(), arguments.end(),
+                    header.arguments().begin(), header.arguments().end())) {
+      continue;
+    }
+
+    auto includes = ReadIncludePrefix(source);
+    if (includes.size() < static_cast<size_t>(header.includes_size()) ||
+        !std::equal(header.includes().begin(), header.includes().end(),
+                    includes.begin())) {
+      return nullptr;
+    }
+    return &header;
+  }
+  return nullptr;
+}
@@ -0,0 +1,50 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <string>
+#include <vector>
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+#include "build_system/proto/intercept.pb.h"
+#include "build_system/replacer/compilation_command.h"
+
+/// @returns the prerequisites of the make rule written by -MD, with the
+/// escapes of spaces, '#' and '$' in file names resolved.
+std::vector<std::string> ParseDependencyRule(absl::string_view rule);
+
+/// Reads the #include directives at the start of source, up to the first line
+/// that is neither an include, blank nor a comment. Quoted includes found
+/// next to source are returned as "absolute path", all others as written.
+std::vector<std::string> ReadIncludePrefix(const std::string &source);
+
+/// @returns arguments without input files, outputs and dependency file
+/// options, which are equal for all compilations that can share a
+/// precompiled header. Mirrored by types.SharedArguments in Go.
+CompilationCommand::ArgsT PchGroupArguments(
+    const CompilationCommand::ArgsT &arguments);
+
+/// The precompiled headers planned for a build.
+class PrecompiledHeaders {
+ public:
+  explicit PrecompiledHeaders(PrecompiledHeaderPlan plan)
+      : plan_(std::move(plan)) {}
+
+  /// Reads a PrecompiledHeaderPlan in text format.
+  static absl::optional<PrecompiledHeaders> Load(const std::string &path);
+
+  /// Makes the replaced command cc use the precompiled header of its group,
+  /// building it first if it is missing or stale. cc is left unchanged if it
+  /// is not a single C or C++ compilation, its arguments diverge from every
+  /// group, its source does not start with the group's includes, or the
+  /// header cannot be built.
+  void Use(CompilationCommand *cc, const std::string &directory) const;
+
+ private:
+  const PrecompiledHeader *Find(const CompilationCommand &cc,
+                                const std::string &directory,
+                                const std::string &source,
+                                const std::string &language) const;
+
+  PrecompiledHeaderPlan plan_;
+};
@@ -0,0 +1,174 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/replacer/probe_cache.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <algorithm>
+#include <functional>
+#include <set>
+#include <sstream>
+#include <vector>
+#include "absl/strings/match.h"
+#include "absl/strings/string_view.h"
+#include "build_system/replacer/cc_arg_info.h"
+#include "build_system/replacer/io.h"
+#include "build_system/replacer/path.h"
+
+namespace {
+
+/// Arguments that make the driver print an answer and exit, apart from the
+/// -print-* family.
+const std::set<absl::string_view> PROBE_ARGUMENTS = {
+    "--version",    "-v",          "-dumpmachine",
+    "-dumpversion", "-dumpfullversion", "-dumpspecs",
+};
+
+/// Environment variables that change what drivers answer.
+const std::set<absl::string_view> DRIVER_VARIABLES = {
+    "PATH",          "COMPILER_PATH",  "GCC_EXEC_PREFIX",
+    "LIBRARY_PATH",  "CPATH",          "C_INCLUDE_PATH",
+    "CPLUS_INCLUDE_PATH", "SDKROOT",   "CCC_OVERRIDE_OPTIONS",
+    "LANG",          "LANGUAGE",       "LC_ALL",
+    "LC_CTYPE",      "LC_MESSAGES",
+};
+
+/// Prefixes of the variables read by compiler wrappers such as afl-clang.
+const std::vector<absl::string_view> WRAPPER_VARIABLE_PREFIXES = {"AFL_"};
+
+bool is_probe_argument(absl::string_view argument) {
+  return PROBE_ARGUMENTS.count(argument) > 0 ||
+         absl::StartsWith(argument, "-print-") ||
+         absl::StartsWith(argument, "--print-");
+}
+
+int arity(absl::string_view argument) {
+  auto info = CC_ARGUMENTS_INFO.find(argument);
+  return info == CC_ARGUMENTS_INFO.end() ? 0 : info->second.arity;
+}
+
+bool is_driver_variable(absl::string_view variable) {
+  auto name = variable.substr(0, variable.find('='));
+  if (DRIVER_VARIABLES.count(name) > 0) return true;
+  return std::any_of(
+      WRAPPER_VARIABLE_PREFIXES.begin(), WRAPPER_VARIABLE_PREFIXES.end(),
+      [&](absl::string_view prefix) { return absl::StartsWith(name, prefix); });
+}
+
+std::string entry_name(const std::string &key) {
+  std::stringstream name;
+  name << std::hex << std::hash<std::string>{}(key);
+  return name.str();
+}
+
+}  // anonymous namespace
+
+bool IsProbeCommand(const CompilationCommand &cc) {
+  if (cc.arguments.empty()) return false;
+
+  bool probes = false;
+  for (auto it = std::next(cc.arguments.begin()); it != cc.arguments.end();
+       ++it) {
+    if (is_probe_argument(*it)) {
+      probes = true;
+      continue;
+    }
+    // inputs, outputs and anything that makes the driver do work
+    if (*it == "-" || *it == "-o" || *it == "-c" || *it == "-E" ||
+        *it == "-S" || *it == "-###" || !absl::StartsWith(*it, "-")) {
+      return false;
+    }
+    for (int skip = arity(*it); skip > 0; --skip) {
+      if (++it == cc.arguments.end()) return false;
+    }
+  }
+  return probes;
+}
+
+absl::optional<std::string> ProbeCache::Key(const CompilationCommand &cc,
+                                             char *const envp[]) {
+  auto command = get_absolute_command_path(cc.command);
+  char *compiler = realpath(command.data(), nullptr);
+  if (compiler == nullptr) return {};
+  std::string key = compiler;
+  free(compiler);
+
+  struct stat info;
+  if (stat(key.data(), &info) != 0) return {};
+  key += '\0' + std::to_string(info.st_mtim.tv_sec) + "." +
+         std::to_string(info.st_mtim.tv_nsec) + '\0' +
+         std::to_string(info.st_size);
+
+  // relative paths in the arguments, e.g. of -B, --sysroot, -I or @file, and
+  // the drivers' search for relative tools are resolved against it
+  key += '\0' + current_directory();
+
+  // drivers choose their mode by the name they were called by
+  key += '\0' + basename(cc.arguments.front());
+  for (auto it = std::next(cc.arguments.begin()); it != cc.arguments.end();
+       ++it) {
+    key += '\0' + *it;
+  }
+
+  std::vector<std::string> variables;
+  for (auto env = envp; *env != nullptr; ++env) {
+    if (is_driver_variable(*env)) variables.emplace_back(*env);
+  }
+  std::sort(variables.begin(), variables.end());
+  for (const auto &variable : variables) key += '\0' + variable;
+  return key;
+}
+
+absl::optional<ProbeAnswer> ProbeCache::Answer(const CompilationCommand &cc,
+                                               char *const envp[]) const {
+  if (!IsProbeCommand(cc)) return {};
+  auto key = Key(cc, envp);
+  if (!key) return {};
+
+  auto path = directory_ + "/" + entry_name(*key);
+  auto content = read_file(path);
+  ProbeAnswer cached;
+  auto occupied = content && cached.ParseFromString(*content);
+  if (occupied && cached.key() == *key) return cached;
+
+  auto answer = Run(cc, envp, *key);
+  // an entry of another key with the same hash is kept, and concurrent
+  // readers see a new entry whole or not at all
+  if (answer && !occupied) write_file(path, answer->SerializeAsString());
+  return answer;
+}
+
+absl::optional<ProbeAnswer> ProbeCache::Run(const CompilationCommand &cc,
+                                            char *const envp[],
+                                            const std::string &key) const {
+  auto stdout_path = directory_ + "/stdout.XXXXXX";
+  auto stderr_path = directory_ + "/stderr.XXXXXX";
+  StandardStreams streams;
+  streams.input = open("/dev/null", O_RDONLY);
+  streams.output = mkstemp(&stdout_path[0]);
+  streams.error = mkstemp(&stderr_path[0]);
+
+  absl::optional<int> status;
+  if (streams.input >= 0 && streams.output >= 0 && streams.error >= 0) {
+    status = run(get_absolute_command_path(cc.command), cc.arguments,
+                 without_preload(envp).data(), streams);
+  }
+  for (auto fd : {streams.input, streams.output, streams.error}) {
+    if (fd >= 0) close(fd);
+  }
+
+  absl::optional<ProbeAnswer> answer;
+  auto standard_output = read_file(stdout_path);
+  auto standard_error = read_file(stderr_path);
+  if (status && standard_output && standard_error) {
+    answer.emplace();
+    answer->set_key(key);
+    answer->set_exit_status(*status);
+    answer->set_standard_output(*standard_output);
+    answer->set_standard_error(*standard_error);
+  }
+  unlink(stdout_path.data());
+  unlink(stderr_path.data());
+  return answer;
+}
@@ -0,0 +1,42 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <string>
+#include "absl/types/optional.h"
+#include "build_system/proto/intercept.pb.h"
+#include "build_system/replacer/compilation_command.h"
+
+/// @returns whether cc only queries the compiler, e.g. with --version,
+/// -dumpmachine or -print-search-dirs, and neither reads inputs nor writes
+/// outputs. Its answer then depends on the compiler, the arguments and the
+/// environment only.
+bool IsProbeCommand(const CompilationCommand &cc);
+
+/// Answers to the probe commands of a build, shared by its processes through
+/// a directory. Configure scripts ask the same questions many times, and each
+/// is a full start of the replaced compiler's driver.
+class ProbeCache {
+ public:
+  explicit ProbeCache(std::string directory)
+      : directory_(std::move(directory)) {}
+
+  /// Returns the answer to the probe command cc, which is run with envp and
+  /// recorded if it was not asked before. Returns nothing if cc is no probe or
+  /// could not be run.
+  absl::optional<ProbeAnswer> Answer(const CompilationCommand &cc,
+                                     char *const envp[]) const;
+
+  /// Identifies the answer of cc by the path, modification time and size of
+  /// the compiler, the working directory, the arguments and the environment
+  /// variables that drivers read.
+  static absl::optional<std::string> Key(const CompilationCommand &cc,
+                                         char *const envp[]);
+
+ private:
+  absl::optional<ProbeAnswer> Run(const CompilationCommand &cc,
+                                  char *const envp[],
+                                  const std::string &key) const;
+
+  std::string directory_;
+};
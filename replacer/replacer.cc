@@ -3,6 +3,7 @@
 #include "build_system/replacer/replacer.h"
 #include "build_system/replacer/cc_arg_info.h"
 #include "build_system/replacer/path.h"
+#include "build_system/replacer/precompiled_header.h"
 #include "re2/re2.h"
 
 namespace {
@@ -20,20 +21,33 @@ auto getArity(absl::string_view argument) -> int {
 
 absl::optional<CompilationCommand> Replacer::Replace(
     CompilationCommand cc) const {
-  auto rule = GetMatchingRule(cc.command);
-  if (!rule) return {};
+  auto rule_index = FindMatchingRule(cc.command);
+  if (!rule_index) return {};
 
-  if (rule->replace_command().empty()) return cc;
+  return ApplyRule(std::move(cc), *rule_index);
+}
+
+CompilationCommand Replacer::ApplyRule(CompilationCommand cc,
+                                       int rule_index) const {
+  const auto &rule = settings_.matching_rules(rule_index);
+  if (rule.replace_command().empty()) return cc;
 
-  RemoveArguments(&cc.arguments, *rule);
-  AddArguments(&cc.arguments, *rule);
+  RemoveArguments(&cc.arguments, rule);
+  AddArguments(&cc.arguments, rule);
 
-  cc.command = rule->replace_command();
+  cc.command = rule.replace_command();
 
   cc.arguments.front() = cc.command;
   return cc;
 }
 
+void Replacer::UsePrecompiledHeader(CompilationCommand *replaced_cc) const {
+  if (settings_.precompiled_header_plan().empty()) return;
+
+  auto headers = PrecompiledHeaders::Load(settings_.precompiled_header_plan());
+  if (headers) headers->Use(replaced_cc, current_directory());
+}
+
 void Replacer::AddArguments(CompilationCommand::ArgsT *arguments,
                             const MatchingRule &rule) const {
   for (const auto &argument : rule.add_arguments()) {
@@ -53,13 +67,13 @@ void Replacer::RemoveArguments(CompilationCommand::ArgsT *arguments,
   }
 }
 
-absl::optional<MatchingRule> Replacer::GetMatchingRule(
-    std::string command_path) const {
+absl::optional<int> Replacer::FindMatchingRule(
+    const std::string &command_path) const {
   auto command = basename(command_path);
 
-  for (auto rule : settings_.matching_rules()) {
-    if (RE2::FullMatch(command, rule.match_command())) {
-      return rule;
+  for (int i = 0; i < settings_.matching_rules_size(); i++) {
+    if (RE2::FullMatch(command, settings_.matching_rules(i).match_command())) {
+      return i;
     }
   }
   return {};
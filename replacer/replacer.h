@@ -17,6 +17,18 @@ class Replacer {
   absl::optional<CompilationCommand> Replace(
       CompilationCommand original_cc) const;
 
+  /// @returns the index of the first rule in settings matching the basename
+  /// of command_path, nothing if no rule matches
+  absl::optional<int> FindMatchingRule(const std::string &command_path) const;
+
+  /// Transforms original_cc according to the rule at rule_index in settings.
+  CompilationCommand ApplyRule(CompilationCommand original_cc,
+                               int rule_index) const;
+
+  /// Makes the replaced command use a precompiled header from the plan in
+  /// settings, if there is one for it. See PrecompiledHeaders::Use.
+  void UsePrecompiledHeader(CompilationCommand *replaced_cc) const;
+
  private:
   void AddArguments(CompilationCommand::ArgsT *arguments,
                     const MatchingRule &rule) const;
@@ -24,7 +36,5 @@ class Replacer {
   void RemoveArguments(CompilationCommand::ArgsT *arguments,
                        const MatchingRule &rule) const;
 
-  absl::optional<MatchingRule> GetMatchingRule(std::string command_path) const;
-
   const InterceptSettings &settings_;
 };
@@ -0,0 +1,38 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/replacer/side_outputs.h"
+
+#include <algorithm>
+#include <vector>
+#include "absl/strings/match.h"
+
+namespace {
+
+/// Prefixes of the options, which also cover their "=value" and joined forms.
+const std::vector<absl::string_view> SIDE_OUTPUT_PREFIXES = {
+    // coverage and profiling
+    "--coverage",
+    "-coverage",
+    "-fprofile-arcs",
+    "-ftest-coverage",
+    "-fcoverage-mapping",
+    "-fprofile-generate",
+    "-fprofile-instr-generate",
+    // files next to the object or named explicitly
+    "-gsplit-dwarf",
+    "-fstack-usage",
+    "-save-temps",
+    "-MJ",
+    "--serialize-diagnostics",
+    "-ftime-trace",
+    "-fdump-",
+    "-aux-info",
+};
+
+}  // namespace
+
+bool WritesSideOutputs(absl::string_view argument) {
+  return std::any_of(
+      SIDE_OUTPUT_PREFIXES.begin(), SIDE_OUTPUT_PREFIXES.end(),
+      [&](absl::string_view prefix) { return absl::StartsWith(argument, prefix); });
+}
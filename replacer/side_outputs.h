@@ -0,0 +1,12 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include "absl/strings/string_view.h"
+
+/// @returns whether argument makes the compiler write files besides the
+/// object and the dependency file, e.g. split DWARF, stack usage or
+/// -save-temps, or instruments the object for coverage or profiling, which
+/// then derives its data files from the object's path. Such compilations only
+/// produce their outputs where they run.
+bool WritesSideOutputs(absl::string_view argument);
@@ -0,0 +1,36 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#include "build_system/replacer/source_files.h"
+
+#include <set>
+
+namespace {
+
+const std::set<absl::string_view> INPUT_SUFFIXES = {
+    ".c",  ".i",   ".ii", ".m",  ".mi",  ".mm",  ".mii",
+    ".C",  ".cc",  ".CC", ".cp", ".cpp", ".cxx", ".c++",
+    ".C++", ".txx", ".s", ".S",  ".sx",  ".asm",
+};
+
+const std::set<absl::string_view> CXX_SUFFIXES = {
+    ".C", ".cc", ".CC", ".cp", ".cpp", ".cxx", ".c++", ".C++", ".txx",
+};
+
+}  // namespace
+
+absl::string_view FileSuffix(absl::string_view file) {
+  auto dot = file.rfind('.');
+  if (dot == absl::string_view::npos) return {};
+  return file.substr(dot);
+}
+
+bool IsInputFile(absl::string_view argument) {
+  return INPUT_SUFFIXES.count(FileSuffix(argument)) > 0;
+}
+
+absl::optional<std::string> SourceLanguage(absl::string_view file) {
+  auto suffix = FileSuffix(file);
+  if (suffix == ".c") return std::string("c");
+  if (CXX_SUFFIXES.count(suffix) > 0) return std::string("c++");
+  return {};
+}
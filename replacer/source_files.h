@@ -0,0 +1,19 @@
+// Copyright (c) 2018 Code Intelligence. All rights reserved.
+
+#pragma once
+
+#include <string>
+#include "absl/strings/string_view.h"
+#include "absl/types/optional.h"
+
+/// @returns the suffix of file from its last dot on, e.g. ".cc", or an empty
+/// string if it has none.
+absl::string_view FileSuffix(absl::string_view file);
+
+/// @returns whether argument is a source file of a compiler, judged by its
+/// suffix. Mirrored by types.IsInputFile in Go.
+bool IsInputFile(absl::string_view argument);
+
+/// @returns "c" or "c++" for C and C++ sources, nothing for other files.
+/// Mirrored by types.SourceLanguage in Go.
+absl::optional<std::string> SourceLanguage(absl::string_view file);
@@ -0,0 +1,58 @@
+#include "build_system/replacer/argument_delta.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+InterceptSettings SetupSettings() {
+  InterceptSettings settings;
+  auto rule = settings.add_matching_rules();
+  rule->add_add_arguments("-O0");
+  rule = settings.add_matching_rules();
+  rule->add_add_arguments("-g");
+  rule->add_add_arguments("-fsanitize=address");
+  return settings;
+}
+
+}  // namespace
+
+TEST(ArgumentDelta, ReferencesSharedArguments) {
+  auto settings = SetupSettings();
+  CompilationCommand original(
+      "gcc", {"gcc", "-O2", "-I", "inc", "hello.c", "-o", "hello.o"});
+  CompilationCommand replaced("clang", {"clang", "-I", "inc", "hello.c", "-o",
+                                        "hello.o", "-g", "-fsanitize=address"});
+
+  auto delta = EncodeArgumentDelta(original, replaced, settings, 1);
+  EXPECT_EQ(delta.first_argument(), "clang");
+  ASSERT_EQ(delta.removed_indices_size(), 1);
+  EXPECT_EQ(delta.removed_indices(0), 1u);
+  EXPECT_EQ(delta.appended_arguments_size(), 0);
+  EXPECT_EQ(delta.shared_rule(), 2);
+
+  EXPECT_EQ(DecodeArgumentDelta(original, delta, settings), replaced.arguments);
+}
+
+TEST(ArgumentDelta, RoundTripsUnrelatedArguments) {
+  auto settings = SetupSettings();
+  CompilationCommand original("cc", {"cc", "a.c", "-O0", "b.c"});
+  CompilationCommand replaced("cc", {"cc", "b.c", "-O0", "-DX", "-O0"});
+
+  auto delta = EncodeArgumentDelta(original, replaced, settings, 0);
+  EXPECT_TRUE(delta.first_argument().empty());
+  EXPECT_EQ(delta.shared_rule(), 1);
+
+  EXPECT_EQ(DecodeArgumentDelta(original, delta, settings), replaced.arguments);
+}
+
+TEST(ArgumentDelta, ReferencesOnlyTheMatchedRule) {
+  auto settings = SetupSettings();
+  CompilationCommand original("cc", {"cc", "-c", "a.c"});
+  CompilationCommand replaced("cc", {"cc", "-c", "a.c", "-O0"});
+
+  auto delta = EncodeArgumentDelta(original, replaced, settings, 1);
+  EXPECT_EQ(delta.shared_rule(), 0);
+  ASSERT_EQ(delta.appended_arguments_size(), 1);
+  EXPECT_EQ(delta.appended_arguments(0), "-O0");
+
+  EXPECT_EQ(DecodeArgumentDelta(original, delta, settings), replaced.arguments);
+}
@@ -0,0 +1,64 @@
+#include "build_system/replacer/io.h"
+#include "build_system/replacer/path.h"
+#include "gtest/gtest.h"
+
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace {
+
+struct IoTest : public ::testing::Test {
+  std::string root;
+
+  IoTest() : root(current_directory() + "/io_sandbox") {
+    mkdir(root.data(), 0700);
+  }
+
+  ~IoTest() override { rmrf(&root[0]); }
+};
+
+TEST_F(IoTest, WritesAndReadsFiles) {
+  auto path = root + "/file";
+  EXPECT_FALSE(read_file(path));
+
+  std::string content("binary\0content", 14);
+  ASSERT_TRUE(write_file(path, content));
+  EXPECT_EQ(read_file(path), content);
+  ASSERT_TRUE(write_file(path, "replaced"));
+  EXPECT_EQ(read_file(path), std::string("replaced"));
+
+  auto temporary = path + ".tmp." + std::to_string(getpid());
+  EXPECT_NE(access(temporary.data(), F_OK), 0);
+
+  EXPECT_FALSE(write_file(root + "/missing/file", content));
+}
+
+TEST_F(IoTest, RunsCommands) {
+  EXPECT_EQ(run("sh", {"sh", "-c", "exit 3"}, environ), 3);
+  EXPECT_EQ(run("true", {"true"}, environ), 0);
+  EXPECT_FALSE(run(root + "/missing", {"missing"}, environ));
+  EXPECT_FALSE(run("sh", {"sh", "-c", "kill -9 $$"}, environ));
+}
+
+TEST_F(IoTest, RedirectsStreams) {
+  auto output = root + "/output";
+  StandardStreams streams;
+  streams.output = open(output.data(), O_WRONLY | O_CREAT | O_TRUNC, 0600);
+  ASSERT_GE(streams.output, 0);
+  EXPECT_EQ(run("sh", {"sh", "-c", "echo answer"}, environ, streams), 0);
+  close(streams.output);
+  EXPECT_EQ(read_file(output), std::string("answer\n"));
+}
+
+TEST_F(IoTest, RemovesPreload) {
+  char preload[] = "LD_PRELOAD=interceptor.so";
+  char path[] = "PATH=/bin";
+  char *envp[] = {preload, path, nullptr};
+  auto environment = without_preload(envp);
+  ASSERT_EQ(environment.size(), 2u);
+  EXPECT_STREQ(environment[0], "PATH=/bin");
+  EXPECT_EQ(environment[1], nullptr);
+}
+
+}  // namespace
@@ -0,0 +1,116 @@
+#include "build_system/replacer/precompiled_header.h"
+#include "build_system/replacer/path.h"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <fstream>
+
+namespace {
+
+void WriteFile(const std::string &path, const std::string &content) {
+  std::ofstream(path) << content;
+}
+
+struct PrecompiledHeaderTest : public ::testing::Test {
+  std::string root;
+  std::string header;
+  PrecompiledHeaderPlan plan;
+
+  PrecompiledHeaderTest() : root(current_directory() + "/pch_sandbox") {
+    mkdir(root.data(), 0700);
+    WriteFile(root + "/local.h", "#pragma once\n");
+    WriteFile(root + "/a.c",
+              "/* license\n * header */\n"
+              "#include <stdio.h>\n"
+              "// comment\n"
+              "#  include \"local.h\"\n"
+              "#include \"missing.h\"\n"
+              "int x;\n"
+              "#include <stdlib.h>\n");
+    WriteFile(root + "/b.c", "#include <stdlib.h>\nint y;\n");
+
+    header = root + "/group.h";
+    WriteFile(header, "#include <stdio.h>\n");
+    WriteFile(header + ".pch", "");
+    WriteFile(header + ".pch.d", "group.h.pch: " + header + "\n");
+
+    auto group = plan.add_headers();
+    group->set_directory(root);
+    group->set_language("c");
+    for (auto argument : {"clang", "-c", "-O0"}) group->add_arguments(argument);
+    group->add_includes("<stdio.h>");
+    group->set_header(header);
+  }
+
+  ~PrecompiledHeaderTest() override { rmrf(const_cast<char *>(root.data())); }
+};
+
+}  // namespace
+
+TEST_F(PrecompiledHeaderTest, ReadsIncludePrefix) {
+  auto includes = ReadIncludePrefix(root + "/a.c");
+  EXPECT_EQ(includes,
+            std::vector<std::string>({"<stdio.h>", "\"" + root + "/local.h\"",
+                                      "\"missing.h\""}));
+}
+
+TEST_F(PrecompiledHeaderTest, GroupArgumentsOmitInputsAndOutputs) {
+  CompilationCommand::ArgsT arguments = {
+      "clang", "-c", "-O0", "a.c", "-o", "a.o", "-MD", "-MF", "a.d"};
+  EXPECT_EQ(PchGroupArguments(arguments),
+            CompilationCommand::ArgsT({"clang", "-c", "-O0", "-MD"}));
+}
+
+TEST_F(PrecompiledHeaderTest, UsesFreshPrecompiledHeader) {
+  CompilationCommand cc("clang", {"clang", "-c", "-O0", "a.c", "-o", "a.o"});
+  chdir(root.data());
+  PrecompiledHeaders(plan).Use(&cc, root);
+  chdir("..");
+
+  EXPECT_EQ(cc.arguments,
+            CompilationCommand::ArgsT({"clang", "-c", "-O0", "a.c", "-o", "a.o",
+                                       "-include-pch", header + ".pch"}));
+}
+
+TEST_F(PrecompiledHeaderTest, UsesPrecompiledHeaderWithEscapedDependencies) {
+  WriteFile(root + "/with space.h", "");
+  WriteFile(header + ".pch.d", "group.h.pch: " + header + " \\\n " + root +
+                                   "/with\\ space.h\n" + root +
+                                   "/with\\ space.h:\n");
+  WriteFile(header + ".pch", "");
+
+  CompilationCommand cc("clang", {"clang", "-c", "-O0", "a.c"});
+  chdir(root.data());
+  PrecompiledHeaders(plan).Use(&cc, root);
+  chdir("..");
+
+  EXPECT_EQ(cc.arguments,
+            CompilationCommand::ArgsT({"clang", "-c", "-O0", "a.c",
+                                       "-include-pch", header + ".pch"}));
+}
+
+TEST(ParseDependencyRule, ResolvesEscapes) {
+  EXPECT_EQ(ParseDependencyRule("my\\ pch.gch: /src/my\\ header.h \\\n"
+                                "  /src/cost$$.h\t/src/\\#1.h \\\r\n"
+                                " /src/last.h\n"
+                                "/src/my\\ header.h:\n"),
+            std::vector<std::string>({"/src/my header.h", "/src/cost$.h",
+                                      "/src/#1.h", "/src/last.h"}));
+  EXPECT_TRUE(ParseDependencyRule("no rule\n").empty());
+}
+
+TEST_F(PrecompiledHeaderTest, KeepsCommandsThatDoNotFit) {
+  const CompilationCommand commands[] = {
+      {"clang", {"clang", "-c", "-O2", "a.c"}},  // diverging arguments
+      {"clang", {"clang", "-c", "-O0", "b.c"}},  // other include prefix
+      {"clang", {"clang", "-O0", "a.c"}},        // not only compiling
+  };
+
+  chdir(root.data());
+  for (const auto &original : commands) {
+    auto cc = original;
+    PrecompiledHeaders(plan).Use(&cc, root);
+    EXPECT_EQ(cc.arguments, original.arguments);
+  }
+  chdir("..");
+}
@@ -0,0 +1,146 @@
+#include "build_system/replacer/probe_cache.h"
+#include "build_system/replacer/path.h"
+#include "gtest/gtest.h"
+
+#include <sys/stat.h>
+#include <fstream>
+#include <sstream>
+
+namespace {
+
+struct ProbeCacheTest : public ::testing::Test {
+  std::string root;
+  std::string compiler;
+  std::string runs;
+
+  ProbeCacheTest() : root(current_directory() + "/probe_sandbox") {
+    mkdir(root.data(), 0700);
+    compiler = root + "/fake-gcc";
+    runs = root + "/runs";
+    WriteCompiler("version 1");
+  }
+
+  ~ProbeCacheTest() override { rmrf(const_cast<char *>(root.data())); }
+
+  /// A compiler that counts its runs and answers with version.
+  void WriteCompiler(const std::string &version) {
+    std::ofstream(compiler) << "#!/bin/sh\n"
+                            << "echo run >> " << runs << "\n"
+                            << "echo '" << version << "'\n"
+                            << "echo \"$LANG\" >&2\n"
+                            << "exit 3\n";
+    chmod(compiler.data(), 0755);
+  }
+
+  int Runs() {
+    std::ifstream file(runs);
+    std::string line;
+    int count = 0;
+    while (std::getline(file, line)) ++count;
+    return count;
+  }
+};
+
+CompilationCommand Command(CompilationCommand::ArgsT arguments) {
+  auto command = arguments.front();
+  return {command, std::move(arguments)};
+}
+
+}  // namespace
+
+TEST(IsProbeCommand, RecognizesQueries) {
+  EXPECT_TRUE(IsProbeCommand(Command({"gcc", "--version"})));
+  EXPECT_TRUE(IsProbeCommand(Command({"gcc", "-v"})));
+  EXPECT_TRUE(IsProbeCommand(Command({"clang", "-O2", "-dumpmachine"})));
+  EXPECT_TRUE(IsProbeCommand(
+      Command({"gcc", "-m32", "-print-file-name=libgcc.a"})));
+  EXPECT_TRUE(IsProbeCommand(Command({"gcc", "-x", "c", "-print-search-dirs"})));
+}
+
+TEST(IsProbeCommand, RejectsCompilations) {
+  EXPECT_FALSE(IsProbeCommand(Command({"gcc"})));
+  EXPECT_FALSE(IsProbeCommand(Command({"gcc", "-O2"})));
+  EXPECT_FALSE(IsProbeCommand(Command({"gcc", "-v", "-c", "a.c"})));
+  EXPECT_FALSE(IsProbeCommand(Command({"gcc", "-v", "a.c"})));
+  EXPECT_FALSE(IsProbeCommand(Command({"gcc", "-v", "-E", "-"})));
+  EXPECT_FALSE(
+      IsProbeCommand(Command({"gcc", "-print-prog-name=ld", "-o", "out"})));
+}
+
+TEST_F(ProbeCacheTest, ReplaysRecordedAnswer) {
+  ProbeCache cache(root);
+  char lang[] = "LANG=C";
+  char *envp[] = {lang, nullptr};
+
+  auto first = cache.Answer(Command({compiler, "--version"}), envp);
+  ASSERT_TRUE(first);
+  EXPECT_EQ(first->exit_status(), 3);
+  EXPECT_EQ(first->standard_output(), "version 1\n");
+  EXPECT_EQ(first->standard_error(), "C\n");
+
+  auto second = cache.Answer(Command({compiler, "--version"}), envp);
+  ASSERT_TRUE(second);
+  EXPECT_EQ(second->SerializeAsString(), first->SerializeAsString());
+  EXPECT_EQ(Runs(), 1);
+}
+
+TEST_F(ProbeCacheTest, KeysOnArgumentsEnvironmentAndCompiler) {
+  ProbeCache cache(root);
+  char lang_c[] = "LANG=C", lang_de[] = "LANG=de_DE", home[] = "HOME=/x";
+  char *envp[] = {lang_c, home, nullptr};
+  char *other_home[] = {lang_c, nullptr};
+  char *other_lang[] = {lang_de, nullptr};
+
+  cache.Answer(Command({compiler, "--version"}), envp);
+  cache.Answer(Command({compiler, "--version"}), other_home);
+  EXPECT_EQ(Runs(), 1);
+
+  cache.Answer(Command({compiler, "-dumpmachine"}), envp);
+  EXPECT_EQ(Runs(), 2);
+
+  auto localized = cache.Answer(Command({compiler, "--version"}), other_lang);
+  ASSERT_TRUE(localized);
+  EXPECT_EQ(localized->standard_error(), "de_DE\n");
+  EXPECT_EQ(Runs(), 3);
+
+  WriteCompiler("version 22");
+  auto updated = cache.Answer(Command({compiler, "--version"}), envp);
+  ASSERT_TRUE(updated);
+  EXPECT_EQ(updated->standard_output(), "version 22\n");
+  EXPECT_EQ(Runs(), 4);
+}
+
+TEST_F(ProbeCacheTest, KeysOnWorkingDirectory) {
+  std::ofstream(compiler) << "#!/bin/sh\n"
+                          << "echo run >> " << runs << "\n"
+                          << "pwd\n";
+  chmod(compiler.data(), 0755);
+  auto a = root + "/a", b = root + "/b";
+  mkdir(a.data(), 0700);
+  mkdir(b.data(), 0700);
+
+  ProbeCache cache(root);
+  char *envp[] = {nullptr};
+  auto previous = current_directory();
+  auto probe = Command({compiler, "-Btools", "-print-prog-name=as"});
+  chdir(a.data());
+  auto from_a = cache.Answer(probe, envp);
+  chdir(b.data());
+  auto from_b = cache.Answer(probe, envp);
+  chdir(a.data());
+  auto again_from_a = cache.Answer(probe, envp);
+  chdir(previous.data());
+
+  ASSERT_TRUE(from_a && from_b && again_from_a);
+  EXPECT_EQ(from_a->standard_output(), a + "\n");
+  EXPECT_EQ(from_b->standard_output(), b + "\n");
+  EXPECT_EQ(again_from_a->standard_output(), a + "\n");
+  EXPECT_EQ(Runs(), 2);
+}
+
+TEST_F(ProbeCacheTest, IgnoresCompilations) {
+  ProbeCache cache(root);
+  char *envp[] = {nullptr};
+  EXPECT_FALSE(cache.Answer(Command({compiler, "-c", "a.c"}), envp));
+  EXPECT_EQ(Runs(), 0);
+}
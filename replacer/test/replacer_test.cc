@@ -83,3 +83,13 @@ TEST(Replacer, EmptyReplacement_ShouldKeepOriginalCommand) {
   auto replaced_cc = Replacer(settings).Replace(cc);
   ASSERT_EQ(replaced_cc->command, "/usr/bin/gcc");
 }
+
+TEST(Replacer, FindsFirstMatchingRule) {
+  InterceptSettings settings = SetupSettings(REPLACE_COMPILER);
+  settings.add_matching_rules()->set_match_command("clang\\+\\+");
+  Replacer replacer(settings);
+
+  EXPECT_EQ(replacer.FindMatchingRule("/usr/bin/gcc"), absl::optional<int>(0));
+  EXPECT_EQ(replacer.FindMatchingRule("clang++"), absl::optional<int>(1));
+  EXPECT_FALSE(replacer.FindMatchingRule("/bin/sh"));
+}
@@ -0,0 +1,55 @@
+#include "build_system/replacer/side_outputs.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(SideOutputs, Coverage) {
+  for (auto argument :
+       {"--coverage", "-coverage", "-fprofile-arcs", "-ftest-coverage",
+        "-fcoverage-mapping", "-fprofile-generate", "-fprofile-generate=dir",
+        "-fprofile-instr-generate", "-fprofile-instr-generate=a.profraw"}) {
+    EXPECT_TRUE(WritesSideOutputs(argument)) << argument;
+  }
+}
+
+TEST(SideOutputs, SplitDwarf) {
+  EXPECT_TRUE(WritesSideOutputs("-gsplit-dwarf"));
+  EXPECT_TRUE(WritesSideOutputs("-gsplit-dwarf=single"));
+}
+
+TEST(SideOutputs, StackUsage) { EXPECT_TRUE(WritesSideOutputs("-fstack-usage")); }
+
+TEST(SideOutputs, SaveTemps) {
+  EXPECT_TRUE(WritesSideOutputs("-save-temps"));
+  EXPECT_TRUE(WritesSideOutputs("-save-temps=obj"));
+}
+
+TEST(SideOutputs, CompilationDatabaseFragment) {
+  EXPECT_TRUE(WritesSideOutputs("-MJ"));
+  EXPECT_TRUE(WritesSideOutputs("-MJa.json"));
+}
+
+TEST(SideOutputs, SerializedDiagnostics) {
+  EXPECT_TRUE(WritesSideOutputs("--serialize-diagnostics"));
+}
+
+TEST(SideOutputs, TimeTrace) {
+  EXPECT_TRUE(WritesSideOutputs("-ftime-trace"));
+  EXPECT_TRUE(WritesSideOutputs("-ftime-trace=trace.json"));
+}
+
+TEST(SideOutputs, Dumps) {
+  EXPECT_TRUE(WritesSideOutputs("-fdump-tree-all"));
+  EXPECT_TRUE(WritesSideOutputs("-fdump-rtl-expand"));
+}
+
+TEST(SideOutputs, AuxInfo) { EXPECT_TRUE(WritesSideOutputs("-aux-info")); }
+
+TEST(SideOutputs, PlainCompilation) {
+  for (auto argument : {"-c", "-g", "-O2", "-MD", "-MF", "-fPIC", "-fprofile-use",
+                        "-fdiagnostics-color", "-Wall", "a.c"}) {
+    EXPECT_FALSE(WritesSideOutputs(argument)) << argument;
+  }
+}
+
+}  // namespace
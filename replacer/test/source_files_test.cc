@@ -0,0 +1,29 @@
+#include "build_system/replacer/source_files.h"
+#include "gtest/gtest.h"
+
+namespace {
+
+TEST(SourceFiles, FileSuffix) {
+  EXPECT_EQ(FileSuffix("dir.d/a.cc"), ".cc");
+  EXPECT_EQ(FileSuffix("a.tar.gz"), ".gz");
+  EXPECT_EQ(FileSuffix("Makefile"), "");
+}
+
+TEST(SourceFiles, IsInputFile) {
+  for (auto file : {"a.c", "a.cc", "a.C", "a.cpp", "a.c++", "a.i", "a.S"}) {
+    EXPECT_TRUE(IsInputFile(file)) << file;
+  }
+  for (auto file : {"a.o", "a.h", "a.d", "-c", "liba.so"}) {
+    EXPECT_FALSE(IsInputFile(file)) << file;
+  }
+}
+
+TEST(SourceFiles, SourceLanguage) {
+  EXPECT_EQ(SourceLanguage("src/a.c"), std::string("c"));
+  EXPECT_EQ(SourceLanguage("src/a.cxx"), std::string("c++"));
+  EXPECT_EQ(SourceLanguage("src/a.C"), std::string("c++"));
+  EXPECT_FALSE(SourceLanguage("src/a.i"));
+  EXPECT_FALSE(SourceLanguage("src/a.s"));
+}
+
+}  // namespace
@@ -0,0 +1,77 @@
+package types
+
+import "path"
+
+var (
+	inputSuffixes = map[string]struct{}{
+		".c": {}, ".i": {}, ".ii": {}, ".m": {}, ".mi": {}, ".mm": {}, ".mii": {},
+		".C": {}, ".cc": {}, ".CC": {}, ".cp": {}, ".cpp": {}, ".cxx": {}, ".c++": {},
+		".C++": {}, ".txx": {}, ".s": {}, ".S": {}, ".sx": {}, ".asm": {},
+	}
+	cxxSuffixes = map[string]struct{}{
+		".C": {}, ".cc": {}, ".CC": {}, ".cp": {}, ".cpp": {}, ".cxx": {}, ".c++": {},
+		".C++": {}, ".txx": {},
+	}
+	// options whose argument names a per-compilation output
+	outputOptions = map[string]struct{}{"-o": {}, "-MF": {}, "-MT": {}, "-MQ": {}}
+)
+
+// IsInputFile returns whether arg is a source file of a compiler, judged by
+// its suffix.
+func IsInputFile(arg string) bool {
+	_, found := inputSuffixes[path.Ext(arg)]
+	return found
+}
+
+// SourceLanguage returns "c" or "c++" for C and C++ sources and "" for other
+// files.
+func SourceLanguage(file string) string {
+	ext := path.Ext(file)
+	if ext == ".c" {
+		return "c"
+	}
+	if _, found := cxxSuffixes[ext]; found {
+		return "c++"
+	}
+	return ""
+}
+
+// CompiledSources returns the source files in the arguments of a compiler
+// and whether they are only compiled, i.e. -c is given.
+func CompiledSources(arguments []string) (sources []string, compiles bool) {
+	for i, arg := range arguments {
+		if i == 0 {
+			continue
+		}
+		if arg == "-c" {
+			compiles = true
+		}
+		if IsInputFile(arg) {
+			sources = append(sources, arg)
+		}
+	}
+	return sources, compiles
+}
+
+// SharedArguments returns arguments without input files, outputs and
+// dependency file options, which are equal for compilations of different
+// sources with the same flags. Mirrored by PchGroupArguments in
+// replacer/precompiled_header.h.
+func SharedArguments(arguments []string) (res []string) {
+	skipNext := false
+	for _, arg := range arguments {
+		if skipNext {
+			skipNext = false
+			continue
+		}
+		if _, found := outputOptions[arg]; found {
+			skipNext = true
+			continue
+		}
+		if IsInputFile(arg) {
+			continue
+		}
+		res = append(res, arg)
+	}
+	return res
+}
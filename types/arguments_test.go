@@ -0,0 +1,32 @@
+package types
+
+import (
+	"reflect"
+	"testing"
+)
+
+func TestSharedArguments(t *testing.T) {
+	got := SharedArguments([]string{"clang", "-O2", "-MD", "-MF", "a.d", "-c", "a.cc", "-o", "a.o", "-DX"})
+	want := []string{"clang", "-O2", "-MD", "-c", "-DX"}
+	if !reflect.DeepEqual(got, want) {
+		t.Errorf("SharedArguments() = %q, want %q", got, want)
+	}
+}
+
+func TestCompiledSources(t *testing.T) {
+	sources, compiles := CompiledSources([]string{"gcc.c", "-c", "a.c", "b.S", "-o", "x.o"})
+	if want := []string{"a.c", "b.S"}; !reflect.DeepEqual(sources, want) || !compiles {
+		t.Errorf("CompiledSources() = %q, %v, want %q, true", sources, compiles, want)
+	}
+	if _, compiles := CompiledSources([]string{"gcc", "a.o", "-o", "prog"}); compiles {
+		t.Error("link is a compilation")
+	}
+}
+
+func TestSourceLanguage(t *testing.T) {
+	for file, want := range map[string]string{"a.c": "c", "a.cc": "c++", "a.C": "c++", "a.s": "", "a.h": ""} {
+		if got := SourceLanguage(file); got != want {
+			t.Errorf("SourceLanguage(%q) = %q, want %q", file, got, want)
+		}
+	}
+}
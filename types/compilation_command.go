@@ -1,8 +1,120 @@
 package types
 
+import (
+	"encoding/json"
+	"fmt"
+	"strings"
+)
+
 type CompilationCommand struct {
-	Arguments []string `json:"arguments"`
-	Directory string   `json:"directory"`
-	Output    string   `json:"output"`
-	File      string   `json:"file"`
+	Arguments    []string `json:"arguments"`
+	Directory    string   `json:"directory"`
+	Output       string   `json:"output"`
+	File         string   `json:"file"`
+	Dependencies []string `json:"dependencies,omitempty"`
+}
+
+// CompactCompilationDb is a compilation database in which every string and
+// every argument list is stored once and referenced by its index.
+type CompactCompilationDb struct {
+	Strings   []string                    `json:"strings"`
+	Arguments [][]uint32                  `json:"arguments"`
+	Commands  []CompactCompilationCommand `json:"commands"`
+}
+
+// CompactCompilationCommand is a CompilationCommand of a CompactCompilationDb.
+// Arguments is an index into Arguments, all other fields are indices into
+// Strings.
+type CompactCompilationCommand struct {
+	Arguments    uint32   `json:"arguments"`
+	Directory    uint32   `json:"directory"`
+	Output       uint32   `json:"output"`
+	File         uint32   `json:"file"`
+	Dependencies []uint32 `json:"dependencies,omitempty"`
+}
+
+// ParseCompilationDb parses a compile_commands.json. Entries that give the
+// command as a single "command" string instead of "arguments" are split with
+// the quoting rules of the shell. An entry with neither is an error.
+func ParseCompilationDb(data []byte) ([]CompilationCommand, error) {
+	var entries []struct {
+		CompilationCommand
+		Command string `json:"command"`
+	}
+	if err := json.Unmarshal(data, &entries); err != nil {
+		return nil, err
+	}
+	cmds := make([]CompilationCommand, len(entries))
+	for i, entry := range entries {
+		cmds[i] = entry.CompilationCommand
+		if len(cmds[i].Arguments) > 0 {
+			continue
+		}
+		if entry.Command == "" {
+			return nil, fmt.Errorf("entry %d for %q has neither arguments nor command", i, entry.File)
+		}
+		args, err := SplitCommand(entry.Command)
+		if err != nil {
+			return nil, fmt.Errorf("entry %d for %q: %v", i, entry.File, err)
+		}
+		cmds[i].Arguments = args
+	}
+	return cmds, nil
+}
+
+// SplitCommand splits a command line into its arguments like a POSIX shell
+// does, without expanding variables or globs.
+func SplitCommand(command string) ([]string, error) {
+	var args []string
+	var arg []rune
+	inArg := false
+	var quote rune
+	escaped := false
+	for _, c := range command {
+		switch {
+		case escaped:
+			// Inside double quotes a backslash only escapes characters that
+			// are special there.
+			if quote == '"' && !strings.ContainsRune("\"\\$`\n", c) {
+				arg = append(arg, '\\')
+			}
+			if c != '\n' {
+				arg = append(arg, c)
+			}
+			escaped = false
+		case quote == '\'':
+			if c == '\'' {
+				quote = 0
+			} else {
+				arg = append(arg, c)
+			}
+		case c == '\\':
+			escaped = true
+			inArg = true
+		case quote == '"':
+			if c == '"' {
+				quote = 0
+			} else {
+				arg = append(arg, c)
+			}
+		case c == '\'' || c == '"':
+			quote = c
+			inArg = true
+		case c == ' ' || c == '\t' || c == '\n':
+			if inArg {
+				args = append(args, string(arg))
+				arg, inArg = arg[:0], false
+			}
+		default:
+			arg = append(arg, c)
+			inArg = true
+		}
+	}
+	if escaped || quote != 0 {
+		return nil, fmt.Errorf("unterminated quote or escape in %q", command)
+	}
+	if inArg {
+		args = append(args, string(arg))
+	}
+	return args, nil
 }
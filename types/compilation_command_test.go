@@ -0,0 +1,36 @@
+package types
+
+import (
+	"reflect"
+	"testing"
+)
+
+func TestSplitCommand(t *testing.T) {
+	got, err := SplitCommand(`gcc  -DA="x y" -DB='a "b"' -DC=\$x "q\"\n" a\ b.c` + "\t-c")
+	want := []string{"gcc", "-DA=x y", `-DB=a "b"`, "-DC=$x", `q"\n`, "a b.c", "-c"}
+	if err != nil || !reflect.DeepEqual(got, want) {
+		t.Errorf("SplitCommand() = %q, %v, want %q", got, err, want)
+	}
+	for _, command := range []string{`gcc "a.c`, `gcc 'a.c`, `gcc a.c\`} {
+		if _, err := SplitCommand(command); err == nil {
+			t.Errorf("SplitCommand(%q) succeeded", command)
+		}
+	}
+}
+
+func TestParseCompilationDb(t *testing.T) {
+	cmds, err := ParseCompilationDb([]byte(`[
+		{"directory": "/d", "file": "a.c", "arguments": ["gcc", "-c", "a.c"]},
+		{"directory": "/d", "file": "b c.c", "command": "gcc -c 'b c.c'"}
+	]`))
+	want := []CompilationCommand{
+		{Arguments: []string{"gcc", "-c", "a.c"}, Directory: "/d", File: "a.c"},
+		{Arguments: []string{"gcc", "-c", "b c.c"}, Directory: "/d", File: "b c.c"},
+	}
+	if err != nil || !reflect.DeepEqual(cmds, want) {
+		t.Errorf("ParseCompilationDb() = %+v, %v, want %+v", cmds, err, want)
+	}
+	if _, err := ParseCompilationDb([]byte(`[{"directory": "/d", "file": "a.c"}]`)); err == nil {
+		t.Error("ParseCompilationDb() accepted an entry without a command")
+	}
+}